@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <sys/mman.h>
+
+// An allocator for the containers is a small copyable handle that provides
+//   void *allocate(size_t bytes, size_t alignment);
+//   void deallocate(void *p, size_t bytes, size_t alignment);
+// and can optionally provide
+//   void *allocate_zeroed(size_t bytes, size_t alignment);
+//   void *reallocate(void *p, size_t old_bytes, size_t new_bytes,
+//                    size_t alignment);
+// where reallocate may move the block but must keep the first
+// min(old_bytes, new_bytes) bytes, and
+//   bool reallocates_in_place(size_t alignment) const;
+// which says whether reallocate keeps blocks of that alignment without
+// copying them, by growing them in place or with mremap. When it would copy,
+// the containers copy into a new allocation themselves, which they have to
+// do anyway to move the columns, and an allocator that does not say is
+// assumed not to copy. The containers store a copy of the allocator and use
+// it for every allocation they make.
+template <class A>
+concept SOAAllocator = std::copy_constructible<A> &&
+                       requires(A a, void *p, size_t n) {
+                         { a.allocate(n, n) } -> std::same_as<void *>;
+                         a.deallocate(p, n, n);
+                       };
+
+template <class A>
+concept ZeroingAllocator = requires(A a, size_t n) {
+  { a.allocate_zeroed(n, n) } -> std::same_as<void *>;
+};
+
+template <class A>
+concept ReallocatingAllocator = requires(A a, void *p, size_t n) {
+  { a.reallocate(p, n, n, n) } -> std::same_as<void *>;
+};
+
+template <SOAAllocator A>
+bool reallocates_in_place(const A &allocator, size_t alignment) {
+  if constexpr (requires { allocator.reallocates_in_place(alignment); }) {
+    return allocator.reallocates_in_place(alignment);
+  } else {
+    return ReallocatingAllocator<A>;
+  }
+}
+
+template <SOAAllocator A>
+void *allocate_zeroed(A &allocator, size_t bytes, size_t alignment) {
+  if constexpr (ZeroingAllocator<A>) {
+    return allocator.allocate_zeroed(bytes, alignment);
+  } else {
+    void *p = allocator.allocate(bytes, alignment);
+    std::memset(p, 0, bytes);
+    return p;
+  }
+}
+
+// the default, plain malloc and free
+struct MallocAllocator {
+  void *allocate(size_t bytes, size_t alignment) {
+    if (alignment <= alignof(std::max_align_t)) {
+      return std::malloc(bytes);
+    }
+    // aligned_alloc wants the size to be a multiple of the alignment
+    if (bytes % alignment != 0) {
+      bytes += alignment - (bytes % alignment);
+    }
+    return std::aligned_alloc(alignment, bytes);
+  }
+
+  void *allocate_zeroed(size_t bytes, size_t alignment) {
+    if (alignment <= alignof(std::max_align_t)) {
+      // calloc hands back fresh zero pages for large blocks
+      return std::calloc(1, bytes);
+    }
+    void *p = allocate(bytes, alignment);
+    std::memset(p, 0, bytes);
+    return p;
+  }
+
+  // realloc only keeps the alignment that malloc would give, a block with a
+  // larger one is copied
+  [[nodiscard]] bool reallocates_in_place(size_t alignment) const {
+    return alignment <= alignof(std::max_align_t);
+  }
+
+  void *reallocate(void *p, size_t old_bytes, size_t new_bytes,
+                   size_t alignment) {
+    if (reallocates_in_place(alignment)) {
+      // for large blocks glibc does this with mremap so nothing is copied
+      return std::realloc(p, new_bytes);
+    }
+    void *new_p = allocate(new_bytes, alignment);
+    std::memcpy(new_p, p, std::min(old_bytes, new_bytes));
+    std::free(p);
+    return new_p;
+  }
+
+  void deallocate(void *p, [[maybe_unused]] size_t bytes,
+                  [[maybe_unused]] size_t alignment) {
+    std::free(p);
+  }
+};
+
+// allocates from a std::pmr::memory_resource, such as an arena
+class PmrAllocator {
+  std::pmr::memory_resource *resource;
+
+public:
+  PmrAllocator() : resource(std::pmr::get_default_resource()) {}
+  PmrAllocator(std::pmr::memory_resource *r) : resource(r) {}
+
+  void *allocate(size_t bytes, size_t alignment) {
+    return resource->allocate(bytes, alignment);
+  }
+
+  void deallocate(void *p, size_t bytes, size_t alignment) {
+    resource->deallocate(p, bytes, alignment);
+  }
+
+  [[nodiscard]] std::pmr::memory_resource *get_resource() const {
+    return resource;
+  }
+};
+
+// maps memory directly from the kernel and backs it with 2MB pages to cut TLB
+// misses on large scans. By default it asks for transparent huge pages with
+// MADV_HUGEPAGE, with explicit_huge_pages it uses MAP_HUGETLB which needs huge
+// pages reserved in /proc/sys/vm/nr_hugepages, and falls back to transparent
+// huge pages if none are available. Every allocation is rounded up to a whole
+// huge page, so this is only meant for large arrays.
+class HugePageAllocator {
+  bool explicit_huge_pages = false;
+
+  static size_t round_to_huge_page(size_t bytes) {
+    return (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+  }
+
+  // maps length bytes aligned to a huge page boundary so the kernel can back
+  // the whole range with huge pages
+  static void *map_transparent(size_t length) {
+    size_t padded_length = length + huge_page_size;
+    void *p = mmap(nullptr, padded_length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+      return nullptr;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(p);
+    uintptr_t aligned_start =
+        (start + huge_page_size - 1) & ~(huge_page_size - 1);
+    if (aligned_start > start) {
+      munmap(p, aligned_start - start);
+    }
+    uintptr_t end = start + padded_length;
+    if (end > aligned_start + length) {
+      munmap(reinterpret_cast<void *>(aligned_start + length),
+             end - (aligned_start + length));
+    }
+    void *aligned = reinterpret_cast<void *>(aligned_start);
+    madvise(aligned, length, MADV_HUGEPAGE);
+    return aligned;
+  }
+
+public:
+  static constexpr size_t huge_page_size = 1UL << 21U;
+
+  HugePageAllocator() = default;
+  explicit HugePageAllocator(bool use_explicit_huge_pages)
+      : explicit_huge_pages(use_explicit_huge_pages) {}
+
+  void *allocate(size_t bytes, [[maybe_unused]] size_t alignment) {
+    size_t length = round_to_huge_page(std::max(bytes, size_t(1)));
+    if (explicit_huge_pages) {
+      void *p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (p != MAP_FAILED) {
+        return p;
+      }
+    }
+    return map_transparent(length);
+  }
+
+  // fresh anonymous mappings are already zero
+  void *allocate_zeroed(size_t bytes, size_t alignment) {
+    return allocate(bytes, alignment);
+  }
+
+  void *reallocate(void *p, size_t old_bytes, size_t new_bytes,
+                   size_t alignment) {
+    size_t old_length = round_to_huge_page(std::max(old_bytes, size_t(1)));
+    size_t new_length = round_to_huge_page(std::max(new_bytes, size_t(1)));
+    if (old_length == new_length) {
+      return p;
+    }
+    void *new_p = mremap(p, old_length, new_length, MREMAP_MAYMOVE);
+    if (new_p != MAP_FAILED) {
+      madvise(new_p, new_length, MADV_HUGEPAGE);
+      return new_p;
+    }
+    // older kernels cannot mremap MAP_HUGETLB mappings
+    new_p = allocate(new_bytes, alignment);
+    std::memcpy(new_p, p, std::min(old_bytes, new_bytes));
+    deallocate(p, old_bytes, alignment);
+    return new_p;
+  }
+
+  void deallocate(void *p, size_t bytes, [[maybe_unused]] size_t alignment) {
+    munmap(p, round_to_huge_page(std::max(bytes, size_t(1))));
+  }
+};
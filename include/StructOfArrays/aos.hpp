@@ -1,13 +1,25 @@
 #pragma once
+#include "allocator.hpp"
+#include "internal/parallel.hpp"
+#include "internal/prefetch.hpp"
+#include "internal/reduce.hpp"
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <ranges>
 #include <tuple>
 
-template <typename... Ts> class AOS {
+// Allocator is used for every allocation the container makes, see
+// allocator.hpp for what it needs to provide
+template <typename Allocator, typename... Ts> class BasicAOS {
+  static_assert(SOAAllocator<Allocator>);
+
 public:
   using T = std::tuple<Ts...>;
 
@@ -21,8 +33,47 @@ private:
   template <int I> using NthType = typename std::tuple_element<I, T>::type;
 
   static constexpr std::array<std::size_t, num_types> sizes = {sizeof(Ts)...};
+
+  // start on a cache line so parallel chunks do not share lines
+  static constexpr size_t base_alignment =
+      std::max(cache_line_size, alignof(T));
+
+  // num_spots is the capacity, num_elements is how many of them are in use
   size_t num_spots;
+  size_t num_elements;
   T *base_array;
+  [[no_unique_address]] Allocator allocator;
+
+  void free_array() {
+    if (base_array != nullptr) {
+      allocator.deallocate(base_array, get_size(), base_alignment);
+    }
+  }
+
+  // move to a new allocation with room for new_num_spots elements
+  void reallocate(size_t new_num_spots) {
+    T *new_base_array = static_cast<T *>(
+        allocator.allocate(get_size_static(new_num_spots), base_alignment));
+    std::copy_n(base_array, num_elements, new_base_array);
+    free_array();
+    base_array = new_base_array;
+    num_spots = new_num_spots;
+  }
+
+  // grow geometrically so that a sequence of appends is amortized O(1)
+  void grow_to_fit(size_t required_spots) {
+    if (required_spots > num_spots) {
+      reserve(std::max({required_spots, num_spots * 2, min_growth_spots}));
+    }
+  }
+
+  static constexpr size_t min_growth_spots = 16;
+
+  static constexpr size_t parallel_grain(size_t grain) {
+    size_t boundary = elements_per_cache_line_boundary<T>();
+    grain = std::max(grain, size_t(1));
+    return ((grain + boundary - 1) / boundary) * boundary;
+  }
 
   template <size_t... Is>
   static auto get_impl_static(
@@ -43,22 +94,128 @@ private:
     return std::forward_as_tuple(std::get<Is>(base_array[i])...);
   }
 
+  // the fields an algorithm works on, all of them if none are given
+  template <size_t... Is> static constexpr auto selected_fields() {
+    if constexpr (sizeof...(Is) > 0) {
+      return std::integer_sequence<size_t, Is...>{};
+    } else {
+      return std::make_index_sequence<num_types>{};
+    }
+  }
+
+  template <bool Parallel, size_t... Selected, class R, class Map,
+            class Combine>
+  R reduce_impl(R identity, Map map, Combine combine, size_t start, size_t end,
+                size_t grain) {
+    if constexpr (Parallel) {
+      return parallel_reduce<Selected...>(identity, map, combine, start, end,
+                                          grain);
+    } else {
+      return reduce<Selected...>(identity, map, combine, start, end);
+    }
+  }
+
+  template <bool Parallel, size_t... Selected, size_t... Is>
+  auto sum_impl(size_t start, size_t end, size_t grain,
+                [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    using R = std::common_type_t<sum_value_t<NthType<Is>>...>;
+    return reduce_impl<Parallel, Selected...>(
+        R(0), [](const auto &...args) { return (R(0) + ... + R(args)); },
+        std::plus<>(), start, end, grain);
+  }
+
+  template <bool Parallel, bool Min, size_t... Selected, size_t... Is>
+  auto
+  min_max_impl(size_t start, size_t end, size_t grain,
+               [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    using R = std::common_type_t<native_value_t<NthType<Is>>...>;
+    auto combine = [](R a, R b) {
+      if constexpr (Min) {
+        return std::min(a, b);
+      } else {
+        return std::max(a, b);
+      }
+    };
+    R identity = Min ? std::numeric_limits<R>::max()
+                     : std::numeric_limits<R>::lowest();
+    return reduce_impl<Parallel, Selected...>(
+        identity,
+        [&combine, identity](const auto &...args) {
+          R result = identity;
+          ((result = combine(result, R(args))), ...);
+          return result;
+        },
+        combine, start, end, grain);
+  }
+
 public:
   static constexpr size_t get_size_static(size_t num_spots) {
     return num_spots * element_size;
   }
   size_t get_size() { return num_spots * element_size; }
 
-  AOS(size_t n) : num_spots(n) {
-    // set the total array to be 64 byte alignmed
+  [[nodiscard]] size_t size() const { return num_elements; }
+
+  [[nodiscard]] size_t capacity() const { return num_spots; }
+
+  [[nodiscard]] bool empty() const { return num_elements == 0; }
 
+  BasicAOS(Allocator alloc = Allocator())
+      : num_spots(0), num_elements(0), base_array(nullptr), allocator(alloc) {}
+
+  BasicAOS(size_t n, Allocator alloc = Allocator())
+      : num_spots(n), num_elements(n), allocator(alloc) {
     uintptr_t length_to_allocate = get_size();
-    base_array = static_cast<T *>(std::malloc(length_to_allocate));
+    base_array =
+        static_cast<T *>(allocator.allocate(length_to_allocate,
+                                            base_alignment));
     std::cout << "allocated size " << length_to_allocate << "\n";
   }
-  ~AOS() { free(base_array); }
+  ~BasicAOS() { free_array(); }
+
+  [[nodiscard]] Allocator get_allocator() const { return allocator; }
   void zero() { std::memset(base_array, 0, get_size()); }
 
+  // make room for at least new_num_spots elements without changing size()
+  void reserve(size_t new_num_spots) {
+    if (new_num_spots > num_spots) {
+      reallocate(new_num_spots);
+    }
+  }
+
+  // release any capacity beyond size()
+  void shrink_to_fit() {
+    if (num_elements < num_spots) {
+      reallocate(num_elements);
+    }
+  }
+
+  void clear() { num_elements = 0; }
+
+  void push_back(const T &v) {
+    grow_to_fit(num_elements + 1);
+    base_array[num_elements] = v;
+    num_elements += 1;
+  }
+
+  template <class... Args> void emplace_back(Args &&...args) {
+    static_assert(sizeof...(Args) == num_types);
+    grow_to_fit(num_elements + 1);
+    base_array[num_elements] =
+        std::forward_as_tuple(std::forward<Args>(args)...);
+    num_elements += 1;
+  }
+
+  // appends every element of range, each element must be assignable to T
+  template <class R> void append(R &&range) {
+    if constexpr (std::ranges::sized_range<R>) {
+      grow_to_fit(num_elements + std::ranges::size(range));
+    }
+    for (auto &&e : range) {
+      push_back(e);
+    }
+  }
+
   template <size_t... Is>
   static auto get_static(void const *base_array,
                          [[maybe_unused]] size_t num_spots, size_t i) {
@@ -88,6 +245,33 @@ public:
     }
   }
 
+  // writes the selected fields of the rows at indices to the arrays out, one
+  // for each selected field and each with room for every index. Each row is
+  // prefetched prefetch_distance lookups ahead.
+  template <size_t... Is, class R>
+  void gather(const R &indices, NthType<Is> *...out) {
+    static_assert(sizeof...(Is) > 0);
+    for_each_prefetched(
+        std::ranges::size(indices),
+        [&](size_t j) { prefetch<false>(base_array + indices[j]); },
+        [&](size_t j) {
+          std::tie(out[j]...) = get<Is...>(indices[j]);
+        });
+  }
+
+  // writes element j of each values array to the selected fields of the row
+  // at indices[j]
+  template <size_t... Is, class R>
+  void scatter(const R &indices, const NthType<Is> *...values) {
+    static_assert(sizeof...(Is) > 0);
+    for_each_prefetched(
+        std::ranges::size(indices),
+        [&](size_t j) { prefetch<true>(base_array + indices[j]); },
+        [&](size_t j) {
+          get<Is...>(indices[j]) = std::forward_as_tuple(values[j]...);
+        });
+  }
+
   static void print_type_details() {
     std::cout << "num types are " << num_types << "\n";
     std::cout << "their alignments are ";
@@ -106,7 +290,7 @@ public:
   void map_range(F f, size_t start = 0,
                  size_t end = std::numeric_limits<size_t>::max()) {
     if (end == std::numeric_limits<size_t>::max()) {
-      end = num_spots;
+      end = num_elements;
     }
     for (size_t i = start; i < end; i++) {
       std::apply(f, get<Is...>(i));
@@ -117,13 +301,138 @@ public:
   void map_range_with_index(F f, size_t start = 0,
                             size_t end = std::numeric_limits<size_t>::max()) {
     if (end == std::numeric_limits<size_t>::max()) {
-      end = num_spots;
+      end = num_elements;
     }
     for (size_t i = start; i < end; i++) {
       std::apply(f, std::tuple_cat(std::make_tuple(i), get<Is...>(i)));
     }
   }
 
+  // like map_range, but the range is split into chunks of about grain
+  // elements which are run in parallel, f may be called concurrently. grain is
+  // rounded up so that no two chunks share a cache line.
+  template <size_t... Is, class F>
+  void parallel_map_range(F f, size_t start = 0,
+                          size_t end = std::numeric_limits<size_t>::max(),
+                          size_t grain = default_parallel_grain) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    parallel_for_chunks(start, end, parallel_grain(grain),
+                        [&](size_t lo, size_t hi) {
+                          map_range<Is...>(f, lo, hi);
+                        });
+  }
+
+  template <size_t... Is, class F>
+  void
+  parallel_map_range_with_index(F f, size_t start = 0,
+                                size_t end = std::numeric_limits<size_t>::max(),
+                                size_t grain = default_parallel_grain) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    parallel_for_chunks(start, end, parallel_grain(grain),
+                        [&](size_t lo, size_t hi) {
+                          map_range_with_index<Is...>(f, lo, hi);
+                        });
+  }
+
+  // Combines map(row) over the selected fields of every row in [start, end).
+  // identity must be the identity of combine, and combine must be associative
+  // and commutative since the rows are combined in no particular order.
+  template <size_t... Is, class R, class Map, class Combine>
+  R reduce(R identity, Map map, Combine combine, size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return reduce_range(
+        start, end, identity,
+        [&](size_t i) -> R { return std::apply(map, get<Is...>(i)); }, combine);
+  }
+
+  // like reduce, but chunks of about grain rows are reduced in parallel and
+  // their partial results are combined at the end
+  template <size_t... Is, class R, class Map, class Combine>
+  R parallel_reduce(R identity, Map map, Combine combine, size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return parallel_reduce_range(
+        start, end, parallel_grain(grain), identity,
+        [&](size_t i) -> R { return std::apply(map, get<Is...>(i)); }, combine);
+  }
+
+  // the sum of every value in the selected fields
+  template <size_t... Is>
+  auto sum(size_t start = 0, size_t end = std::numeric_limits<size_t>::max()) {
+    return sum_impl<false, Is...>(start, end, 0, selected_fields<Is...>());
+  }
+
+  template <size_t... Is>
+  auto parallel_sum(size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) {
+    return sum_impl<true, Is...>(start, end, grain, selected_fields<Is...>());
+  }
+
+  // the smallest value in the selected fields
+  template <size_t... Is>
+  auto min(size_t start = 0, size_t end = std::numeric_limits<size_t>::max()) {
+    return min_max_impl<false, true, Is...>(start, end, 0,
+                                            selected_fields<Is...>());
+  }
+
+  template <size_t... Is>
+  auto parallel_min(size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) {
+    return min_max_impl<true, true, Is...>(start, end, grain,
+                                           selected_fields<Is...>());
+  }
+
+  // the largest value in the selected fields
+  template <size_t... Is>
+  auto max(size_t start = 0, size_t end = std::numeric_limits<size_t>::max()) {
+    return min_max_impl<false, false, Is...>(start, end, 0,
+                                             selected_fields<Is...>());
+  }
+
+  template <size_t... Is>
+  auto parallel_max(size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) {
+    return min_max_impl<true, false, Is...>(start, end, grain,
+                                            selected_fields<Is...>());
+  }
+
+  // the number of rows where pred, called with the selected fields, is true
+  template <size_t... Is, class F>
+  size_t count_if(F pred, size_t start = 0,
+                  size_t end = std::numeric_limits<size_t>::max()) {
+    return reduce<Is...>(
+        size_t(0),
+        [&pred](const auto &...args) -> size_t {
+          return pred(args...) ? 1 : 0;
+        },
+        std::plus<>(), start, end);
+  }
+
+  template <size_t... Is, class F>
+  size_t parallel_count_if(F pred, size_t start = 0,
+                           size_t end = std::numeric_limits<size_t>::max(),
+                           size_t grain = default_parallel_grain) {
+    return parallel_reduce<Is...>(
+        size_t(0),
+        [&pred](const auto &...args) -> size_t {
+          return pred(args...) ? 1 : 0;
+        },
+        std::plus<>(), start, end, grain);
+  }
+
   template <size_t... Is, class F>
   static void
   map_range_with_index_static(void *base_array, size_t num_spots, F f,
@@ -256,5 +565,7 @@ public:
   static Iterator end_static(void const *base_array, size_t num_spots) {
     return Iterator(base_array, num_spots, num_spots);
   }
-  auto end() const { return end_static(base_array, num_spots); }
+  auto end() const { return Iterator(base_array, num_spots, num_elements); }
 };
+
+template <typename... Ts> using AOS = BasicAOS<MallocAllocator, Ts...>;
@@ -0,0 +1,392 @@
+#pragma once
+
+#include "allocator.hpp"
+#include "soa.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+// Blocks of N elements, where each block is laid out as a SOA and the blocks
+// are laid out one after another like an AOS. Reading a whole row touches one
+// cache line per column within a single block, while scans over a single
+// column still run over N contiguous elements at a time.
+template <size_t N, typename Allocator, typename... Ts> class BasicAOSOA {
+  static_assert(N > 0);
+  static_assert(SOAAllocator<Allocator>);
+
+public:
+  using T = std::tuple<Ts...>;
+
+private:
+  static constexpr std::size_t num_types = sizeof...(Ts);
+  static constexpr std::array<std::size_t, num_types> alignments = {
+      std::alignment_of_v<Ts>...};
+
+  template <int I> using NthType = typename std::tuple_element<I, T>::type;
+
+  static constexpr std::array<std::size_t, num_types> sizes = {sizeof(Ts)...};
+
+  // each block is a SOA of N spots packed to the natural alignment of the types
+  using Block = BasicSOA<SOALayout<1>, Allocator, Ts...>;
+  static constexpr size_t block_size = Block::get_size_static(N);
+  static constexpr size_t base_alignment = 64;
+
+  size_t num_spots;
+  void *base_array;
+  [[no_unique_address]] Allocator allocator;
+
+  static void *get_block_static(void *base_array, size_t block) {
+    return static_cast<char *>(base_array) + block * block_size;
+  }
+
+  static const void *get_block_static(const void *base_array, size_t block) {
+    return static_cast<const char *>(base_array) + block * block_size;
+  }
+
+  template <size_t I>
+  static bool print_field_static(void *base_array, size_t num_spots) {
+    for (size_t i = 0; i < num_spots; i++) {
+      std::cout << std::get<0>(get_static<I>(base_array, num_spots, i)) << ", ";
+    }
+    std::cout << "\n";
+    return true;
+  }
+
+  template <size_t... Is>
+  static void print_soa_impl_static(
+      void *base_array, size_t num_spots,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    auto x = {print_field_static<Is>(base_array, num_spots)...};
+    (void)x;
+  }
+
+public:
+  static constexpr size_t get_size_static(size_t num_spots) {
+    return ((num_spots + N - 1) / N) * block_size;
+  }
+  [[nodiscard]] size_t get_size() const { return get_size_static(num_spots); }
+
+  [[nodiscard]] size_t size() const { return num_spots; }
+
+  BasicAOSOA(size_t n, Allocator alloc = Allocator())
+      : num_spots(n), allocator(alloc) {
+    base_array = allocator.allocate(get_size(), base_alignment);
+  }
+
+  // A BasicAOSOA owns its blocks, so like BasicSOA it can only be moved,
+  // which leaves other empty.
+  BasicAOSOA(const BasicAOSOA &other) = delete;
+  BasicAOSOA &operator=(const BasicAOSOA &other) = delete;
+
+  BasicAOSOA(BasicAOSOA &&other) noexcept
+      : num_spots(std::exchange(other.num_spots, 0)),
+        base_array(std::exchange(other.base_array, nullptr)),
+        allocator(other.allocator) {}
+
+  BasicAOSOA &operator=(BasicAOSOA &&other) noexcept {
+    if (this != &other) {
+      if (base_array != nullptr) {
+        allocator.deallocate(base_array, get_size(), base_alignment);
+      }
+      num_spots = std::exchange(other.num_spots, 0);
+      base_array = std::exchange(other.base_array, nullptr);
+      allocator = other.allocator;
+    }
+    return *this;
+  }
+
+  ~BasicAOSOA() {
+    if (base_array != nullptr) {
+      allocator.deallocate(base_array, get_size(), base_alignment);
+    }
+  }
+
+  void swap(BasicAOSOA &other) noexcept {
+    std::swap(num_spots, other.num_spots);
+    std::swap(base_array, other.base_array);
+    std::swap(allocator, other.allocator);
+  }
+
+  friend void swap(BasicAOSOA &a, BasicAOSOA &b) noexcept { a.swap(b); }
+
+  static void zero_static(void *base_array, size_t num_spots) {
+    std::memset(base_array, 0, get_size_static(num_spots));
+  }
+  void zero() const { zero_static(base_array, num_spots); }
+
+  template <size_t... Is>
+  static auto get_static(void *base_array, [[maybe_unused]] size_t num_spots,
+                         size_t i) {
+    return Block::template get_static<Is...>(
+        get_block_static(base_array, i / N), N, i % N);
+  }
+
+  template <size_t... Is>
+  static auto get_static(const void *base_array,
+                         [[maybe_unused]] size_t num_spots, size_t i) {
+    return Block::template get_static<Is...>(
+        get_block_static(base_array, i / N), N, i % N);
+  }
+
+  template <size_t... Is>
+  static auto get_static_ptr(void *base_array,
+                             [[maybe_unused]] size_t num_spots, size_t i) {
+    return Block::template get_static_ptr<Is...>(
+        get_block_static(base_array, i / N), N, i % N);
+  }
+
+  template <size_t... Is> auto get(size_t i) const {
+    return get_static<Is...>(base_array, num_spots, i);
+  }
+
+  template <size_t... Is> auto get_ptr(size_t i) const {
+    return get_static_ptr<Is...>(base_array, num_spots, i);
+  }
+
+  static void print_type_details() {
+    std::cout << "num types are " << num_types << "\n";
+    std::cout << "their alignments are ";
+    for (const auto e : alignments) {
+      std::cout << e << ", ";
+    }
+    std::cout << "\n";
+    std::cout << "their sizes are ";
+    for (const auto e : sizes) {
+      std::cout << e << ", ";
+    }
+    std::cout << "\n";
+    std::cout << "blocks of " << N << " take " << block_size << " bytes\n";
+  }
+
+  template <size_t... Is>
+  static void print_soa_static(void *base_array, size_t num_spots) {
+    if constexpr (sizeof...(Is) > 0) {
+      print_soa_impl_static<Is...>(base_array, num_spots, {});
+    } else {
+      print_soa_impl_static(base_array, num_spots,
+                            std::make_index_sequence<num_types>{});
+    }
+  }
+  template <size_t... Is> void print_soa() const {
+    print_soa_static<Is...>(base_array, num_spots);
+  }
+
+  // walks the range one block at a time so that the inner loop runs over
+  // contiguous elements of each column
+  template <size_t... Is, class F>
+  static void
+  map_range_static(void *base_array, size_t num_spots, F &&f, size_t start = 0,
+                   size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    while (start < end) {
+      size_t block = start / N;
+      size_t block_end = std::min(end - block * N, N);
+      Block::template map_range_static<Is...>(
+          get_block_static(base_array, block), N, f, start % N, block_end);
+      start = (block + 1) * N;
+    }
+  }
+
+  template <size_t... Is, class F>
+  void map_range(F &&f, size_t start = 0,
+                 size_t end = std::numeric_limits<size_t>::max()) const {
+    map_range_static<Is...>(base_array, num_spots, f, start, end);
+  }
+
+  template <size_t... Is, class F>
+  static void
+  map_range_with_index_static(void *base_array, size_t num_spots, F &&f,
+                              size_t start = 0,
+                              size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    while (start < end) {
+      size_t block = start / N;
+      size_t block_end = std::min(end - block * N, N);
+      Block::template map_range_with_index_static<Is...>(
+          get_block_static(base_array, block), N,
+          [&f, block](size_t i, auto &&...args) {
+            f(block * N + i, std::forward<decltype(args)>(args)...);
+          },
+          start % N, block_end);
+      start = (block + 1) * N;
+    }
+  }
+
+  template <size_t... Is, class F>
+  void
+  map_range_with_index(F &&f, size_t start = 0,
+                       size_t end = std::numeric_limits<size_t>::max()) const {
+    map_range_with_index_static<Is...>(base_array, num_spots, f, start, end);
+  }
+
+  template <size_t... Is>
+  static void print_aos_static(void *base_array, size_t num_spots) {
+    map_range_static<Is...>(base_array, num_spots, [](auto... args) {
+      ((std::cout << args << ","), ...) << "\n";
+    });
+  }
+
+  template <size_t... Is> void print_aos() const {
+    print_aos_static<Is...>(base_array, num_spots);
+  }
+
+  template <size_t... Is>
+  static void print_aos_with_index_static(void *base_array, size_t num_spots) {
+    map_range_with_index_static<Is...>(base_array, num_spots, [](auto... args) {
+      ((std::cout << args << ","), ...) << "\n";
+    });
+  }
+
+  template <size_t... Is> void print_aos_with_index() const {
+    print_aos_with_index_static<Is...>(base_array, num_spots);
+  }
+
+  class Iterator {
+
+  public:
+    using difference_type = uint64_t;
+    using value_type = T;
+    using iterator_category = std::random_access_iterator_tag;
+
+    struct reference {
+      void *_array;
+      size_t _spots;
+      uint64_t _index;
+
+      reference &operator=(reference &&v) {
+        get_static(_array, _spots, _index) =
+            get_static(v._array, v._spots, v._index);
+        return *this;
+      }
+      reference &operator=(const value_type &v) {
+        get_static(_array, _spots, _index) = v;
+        return *this;
+      }
+
+      operator value_type() const { return get_static(_array, _spots, _index); }
+
+      template <size_t... Is> auto get() {
+        return get_static<Is...>(_array, _spots, _index);
+      }
+
+      friend void swap(const reference &l, const reference &r) {
+        T temp = get_static(l._array, l._spots, l._index);
+        get_static(l._array, l._spots, l._index) =
+            get_static(r._array, r._spots, r._index);
+        get_static(r._array, r._spots, r._index) = temp;
+      }
+
+      auto operator<(const reference &b) const {
+        return value_type(*this) < value_type(b);
+      }
+      auto operator<(const T &b) const { return value_type(*this) < b; }
+      friend auto operator<(const T &b, const reference &a) {
+        return b < value_type(a);
+      }
+
+      reference(void *array, uint64_t spots, uint64_t index)
+          : _array(array), _spots(spots), _index(index) {}
+    };
+
+    Iterator(void *array, uint64_t spots, uint64_t index)
+        : _array(array), _spots(spots), _index(index) {}
+
+    inline Iterator &operator+=(difference_type rhs) {
+      _index += rhs;
+      return *this;
+    }
+    inline Iterator &operator-=(difference_type rhs) {
+      _index -= rhs;
+      return *this;
+    }
+
+    inline reference operator*() const {
+      return reference(_array, _spots, _index);
+    }
+    inline reference operator[](difference_type rhs) const {
+      return reference(_array, _spots, _index + rhs);
+    }
+
+    inline Iterator &operator++() {
+      ++_index;
+      return *this;
+    }
+    inline Iterator &operator--() {
+      --_index;
+      return *this;
+    }
+    inline Iterator operator++(int) {
+      Iterator tmp(*this);
+      ++_index;
+      return tmp;
+    }
+    inline Iterator operator--(int) {
+      Iterator tmp(*this);
+      --_index;
+      return tmp;
+    }
+
+    inline difference_type operator-(const Iterator &rhs) const {
+      return _index - rhs._index;
+    }
+    inline Iterator operator+(difference_type rhs) const {
+      return Iterator(_array, _spots, _index + rhs);
+    }
+    inline Iterator operator-(difference_type rhs) const {
+      return Iterator(_array, _spots, _index - rhs);
+    }
+    friend inline Iterator operator+(difference_type lhs, const Iterator &rhs) {
+      return Iterator(rhs._array, rhs._spots, lhs + rhs._index);
+    }
+    friend inline Iterator operator-(difference_type lhs, const Iterator &rhs) {
+      return Iterator(rhs._array, rhs._spots, lhs - rhs._index);
+    }
+
+    inline bool operator==(const Iterator &rhs) const {
+      return _index == rhs._index;
+    }
+    inline bool operator!=(const Iterator &rhs) const {
+      return _index != rhs._index;
+    }
+    inline bool operator>(const Iterator &rhs) const {
+      return _index > rhs._index;
+    }
+    inline bool operator<(const Iterator &rhs) const {
+      return _index < rhs._index;
+    }
+    inline bool operator>=(const Iterator &rhs) const {
+      return _index >= rhs._index;
+    }
+    inline bool operator<=(const Iterator &rhs) const {
+      return _index <= rhs._index;
+    }
+
+  private:
+    void *_array;
+    size_t _spots;
+    uint64_t _index = 0;
+  };
+
+  static Iterator begin_static(void *base_array, size_t num_spots) {
+    return Iterator(base_array, num_spots, 0);
+  }
+  auto begin() const { return begin_static(base_array, num_spots); }
+
+  static Iterator end_static(void *base_array, size_t num_spots) {
+    return Iterator(base_array, num_spots, num_spots);
+  }
+  auto end() const { return end_static(base_array, num_spots); }
+};
+
+template <size_t N, typename... Ts>
+using AOSOA = BasicAOSOA<N, MallocAllocator, Ts...>;
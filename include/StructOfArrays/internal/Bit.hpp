@@ -0,0 +1,198 @@
+#pragma once
+
+#include "column.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// A column of bools stored as a dense bitmap, row i in bit i % 64 of word
+// i / 64. Besides reading and writing single rows it answers count, any, all
+// and find_next a word at a time, and walks just the set rows of a range with
+// for_each_set, so a scan of a sparse flag skips 64 clear rows per word.
+// Words are read and written with memcpy since a column only starts on a byte
+// boundary for layouts with a small alignment.
+class bit_column {
+  uint8_t *data = nullptr;
+
+  [[nodiscard]] uint64_t word(size_t w) const {
+    uint64_t x = 0;
+    std::memcpy(&x, data + w * sizeof(uint64_t), sizeof(x));
+    return x;
+  }
+
+  void set_word(size_t w, uint64_t x) const {
+    std::memcpy(data + w * sizeof(uint64_t), &x, sizeof(x));
+  }
+
+  // the bits of word w that lie in [start, end)
+  [[nodiscard]] static uint64_t range_mask(size_t w, size_t start,
+                                           size_t end) {
+    size_t lo = std::max(start, w * 64) - w * 64;
+    size_t hi = std::min(end, w * 64 + 64) - w * 64;
+    uint64_t below_hi = hi == 64 ? ~uint64_t(0) : (uint64_t(1) << hi) - 1;
+    return below_hi & (~uint64_t(0) << lo);
+  }
+
+  // calls f(w, bits) for each word that overlaps [start, end), with the bits
+  // outside the range cleared, and stops early once f returns false
+  template <class F> void for_each_word(size_t start, size_t end, F &&f) const {
+    if (start >= end) {
+      return;
+    }
+    for (size_t w = start / 64; w <= (end - 1) / 64; w++) {
+      if (!f(w, word(w) & range_mask(w, start, end))) {
+        return;
+      }
+    }
+  }
+
+public:
+  using value_type = bool;
+
+  static constexpr size_t bytes_for(size_t n) {
+    return (n + 63) / 64 * sizeof(uint64_t);
+  }
+
+  // 512 rows take one cache line
+  static constexpr size_t elements_per_cache_line = 512;
+
+  bit_column() = default;
+  explicit bit_column(void *start) : data(static_cast<uint8_t *>(start)) {}
+
+  [[nodiscard]] bool get(size_t i) const {
+    return (word(i / 64) >> (i % 64)) & 1;
+  }
+
+  void set(size_t i, bool value) const {
+    uint64_t x = word(i / 64);
+    uint64_t bit = uint64_t(1) << (i % 64);
+    set_word(i / 64, value ? x | bit : x & ~bit);
+  }
+
+  // defined below, since it holds a bit_column
+  class reference;
+
+  reference operator[](size_t i) const;
+
+  void zero_from(size_t start, size_t n) const {
+    size_t first_word = (start + 63) / 64;
+    if (start % 64 != 0) {
+      set_word(start / 64, word(start / 64) & range_mask(start / 64, 0, start));
+    }
+    std::memset(data + first_word * sizeof(uint64_t), 0,
+                bytes_for(n) - first_word * sizeof(uint64_t));
+  }
+
+  void decode(size_t start, size_t end, bool *out) const {
+    uint64_t x = word(start / 64);
+    for (size_t i = start; i < end; i++) {
+      out[i - start] = (x >> (i % 64)) & 1;
+    }
+  }
+
+  // a block is within one word, so it is written with a single store
+  bool encode(const bool *in, size_t start, size_t end) const {
+    uint64_t bits = 0;
+    for (size_t i = start; i < end; i++) {
+      bits |= uint64_t(in[i - start]) << (i % 64);
+    }
+    size_t w = start / 64;
+    uint64_t mask = range_mask(w, start, end);
+    set_word(w, (word(w) & ~mask) | bits);
+    return true;
+  }
+
+  // the number of set rows in [start, end)
+  [[nodiscard]] size_t count(size_t start, size_t end) const {
+    size_t total = 0;
+    for_each_word(start, end, [&total](size_t, uint64_t bits) {
+      total += std::popcount(bits);
+      return true;
+    });
+    return total;
+  }
+
+  // the first set row in [start, end), or end if there is none
+  [[nodiscard]] size_t find_next(size_t start, size_t end) const {
+    size_t found = end;
+    for_each_word(start, end, [&found](size_t w, uint64_t bits) {
+      if (bits == 0) {
+        return true;
+      }
+      found = w * 64 + std::countr_zero(bits);
+      return false;
+    });
+    return found;
+  }
+
+  [[nodiscard]] bool any(size_t start, size_t end) const {
+    return find_next(start, end) != end;
+  }
+
+  [[nodiscard]] bool all(size_t start, size_t end) const {
+    bool all_set = true;
+    for_each_word(start, end, [&all_set, start, end](size_t w, uint64_t bits) {
+      all_set = bits == range_mask(w, start, end);
+      return all_set;
+    });
+    return all_set;
+  }
+
+  // calls f(i) for every set row i in [start, end) in order, taking the
+  // lowest set bit of each word until it is empty
+  template <class F> void for_each_set(size_t start, size_t end, F &&f) const {
+    for_each_word(start, end, [&f](size_t w, uint64_t bits) {
+      while (bits != 0) {
+        f(w * 64 + std::countr_zero(bits));
+        bits &= bits - 1;
+      }
+      return true;
+    });
+  }
+};
+
+// rows in the same word share it, so writing to different rows of one word
+// from different threads is a race
+class bit_column::reference {
+  bit_column column;
+  size_t i;
+
+public:
+  reference(bit_column c, size_t index) : column(c), i(index) {}
+  reference(const reference &other) = default;
+
+  operator bool() const { return column.get(i); }
+
+  const reference &operator=(bool value) const {
+    column.set(i, value);
+    return *this;
+  }
+  const reference &operator=(const reference &other) const {
+    return *this = bool(other);
+  }
+};
+
+inline bit_column::reference bit_column::operator[](size_t i) const {
+  return reference(*this, i);
+}
+
+// A bool which an SOA stores as a single bit, so a column of flags takes an
+// eighth of the space of a column of bool and is counted and searched a word
+// at a time with SOA::count, any, all, find_next and map_range_where.
+class bit {
+public:
+  using encoded_column = bit_column;
+
+private:
+  bool value = false;
+
+public:
+  constexpr bit() = default;
+  constexpr bit(bool x) : value(x) {}
+  bit(const encoded_column::reference &r) : value(r) {}
+  constexpr operator bool() const { return value; }
+  static std::string name() { return "bit"; }
+};
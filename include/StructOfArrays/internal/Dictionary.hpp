@@ -0,0 +1,333 @@
+#pragma once
+
+#include "PackedInt.hpp"
+#include "column.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// A dictionary encoded column of T for columns with few distinct values, such
+// as status codes or region ids. The column starts with a table of up to
+// MaxValues distinct values, followed by a code per row packed in just enough
+// bits to index the table. Code 0 is always T(), so an all zero column reads
+// as zeros, which needs T() to be all zero bytes. A new value is added to the
+// table the first time it is written, so adding values is not thread safe.
+// Values are found by a hash of their bytes into a table of codes kept after
+// the values, so writing a row costs the same however many values there are.
+// Values that compare equal but differ in their bytes, such as structs with
+// padding, may take a code each.
+//
+// Predicates are evaluated once per value in the table and then tested
+// against the codes, so equality and IN list filters and counts by value read
+// only the codes.
+template <class T, size_t MaxValues> class dict_column {
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(MaxValues >= 2 && MaxValues <= 65536);
+
+public:
+  static constexpr size_t code_bits = std::bit_width(MaxValues - 1);
+
+private:
+  using codes_type = packed_uint_column<code_bits>;
+  using code_type = typename codes_type::value_type;
+
+  // at most half full, so probes stay short
+  static constexpr size_t hash_slots = std::bit_ceil(2 * MaxValues);
+
+  // the number of values after the zero value, then the values indexed by
+  // their code from the first offset aligned for T, where the entry for code 0
+  // is never written and so stays zero, then the hash table of codes, where 0
+  // is an empty slot, rounded up so the codes start on a cache line
+  static constexpr size_t values_offset =
+      std::max(sizeof(uint64_t), alignof(T));
+  static constexpr size_t hash_offset =
+      (values_offset + MaxValues * sizeof(T) + sizeof(code_type) - 1) /
+      sizeof(code_type) * sizeof(code_type);
+  static constexpr size_t table_bytes =
+      (hash_offset + hash_slots * sizeof(code_type) + 63) / 64 * 64;
+
+  uint8_t *data = nullptr;
+
+  [[nodiscard]] T *values() const {
+    return reinterpret_cast<T *>(data + values_offset);
+  }
+
+  [[nodiscard]] code_type *hash_table() const {
+    return reinterpret_cast<code_type *>(data + hash_offset);
+  }
+
+  // the first slot to probe for value, from a multiplicative hash of its
+  // bytes
+  [[nodiscard]] static size_t hash_slot(const T &value) {
+    std::array<uint8_t, sizeof(T)> bytes;
+    std::memcpy(bytes.data(), &value, sizeof(T));
+    uint64_t h = 0;
+    for (size_t i = 0; i < sizeof(T); i += sizeof(uint64_t)) {
+      uint64_t word = 0;
+      std::memcpy(&word, bytes.data() + i,
+                  std::min(sizeof(uint64_t), sizeof(T) - i));
+      h = (h ^ word) * 0x9E3779B97F4A7C15ULL;
+    }
+    return (h >> 32) & (hash_slots - 1);
+  }
+
+  // the slot holding the code of value, or the empty slot it would go in
+  [[nodiscard]] size_t probe(const T &value) const {
+    const code_type *hashes = hash_table();
+    size_t slot = hash_slot(value);
+    while (hashes[slot] != 0 && !(values()[hashes[slot]] == value)) {
+      slot = (slot + 1) & (hash_slots - 1);
+    }
+    return slot;
+  }
+
+  [[nodiscard]] codes_type codes() const {
+    return codes_type(data + table_bytes);
+  }
+
+  // the code of value, adding it to the table if it is new, or MaxValues if
+  // the table is full
+  [[nodiscard]] size_t code_for(const T &value) const {
+    if (value == T()) {
+      return 0;
+    }
+    size_t slot = probe(value);
+    if (hash_table()[slot] != 0) {
+      return hash_table()[slot];
+    }
+    size_t code = dictionary_size();
+    if (code == MaxValues) {
+      return MaxValues;
+    }
+    values()[code] = value;
+    hash_table()[slot] = static_cast<code_type>(code);
+    uint64_t count = code;
+    std::memcpy(data, &count, sizeof(count));
+    return code;
+  }
+
+public:
+  using value_type = T;
+  using match_type = std::array<uint8_t, MaxValues>;
+
+  static constexpr size_t bytes_for(size_t n) {
+    return table_bytes + codes_type::bytes_for(n);
+  }
+
+  static constexpr size_t elements_per_cache_line =
+      codes_type::elements_per_cache_line;
+
+  dict_column() = default;
+  explicit dict_column(void *start) : data(static_cast<uint8_t *>(start)) {}
+
+  // the number of values in the table, including the zero value
+  [[nodiscard]] size_t dictionary_size() const {
+    uint64_t count = 0;
+    std::memcpy(&count, data, sizeof(count));
+    return count + 1;
+  }
+
+  [[nodiscard]] T value(size_t code) const { return values()[code]; }
+
+  // the code of value, or MaxValues if it is not in the table
+  [[nodiscard]] size_t find(const T &value) const {
+    if (value == T()) {
+      return 0;
+    }
+    code_type code = hash_table()[probe(value)];
+    return code != 0 ? code : MaxValues;
+  }
+
+  [[nodiscard]] T get(size_t i) const { return value(codes().get(i)); }
+
+  // Writes value to row i and returns true, or returns false and leaves the
+  // row as it was if value is new and the table is full.
+  bool set(size_t i, const T &value) const {
+    size_t code = code_for(value);
+    if (code == MaxValues) {
+      return false;
+    }
+    codes().set(i, code);
+    return true;
+  }
+
+  class reference {
+    dict_column column;
+    size_t i;
+
+  public:
+    reference(dict_column c, size_t index) : column(c), i(index) {}
+    reference(const reference &other) = default;
+
+    operator T() const { return column.get(i); }
+
+    // a value that does not fit in a full table is not written, assign and
+    // fill report it
+    const reference &operator=(const T &value) const {
+      column.set(i, value);
+      return *this;
+    }
+    const reference &operator=(const reference &other) const {
+      return *this = T(other);
+    }
+  };
+
+  reference operator[](size_t i) const { return reference(*this, i); }
+
+  // the table is cleared with the codes when the whole column is
+  void zero_from(size_t start, size_t n) const {
+    if (start == 0) {
+      std::memset(data, 0, bytes_for(n));
+    } else {
+      codes().zero_from(start, n);
+    }
+  }
+
+  void decode(size_t start, size_t end, T *out) const {
+    std::array<code_type, encoded_block_size> block;
+    codes().decode(start, end, block.data());
+    const T *table = values();
+    for (size_t i = 0; i < end - start; i++) {
+      out[i] = table[block[i]];
+    }
+  }
+
+  bool encode(const T *in, size_t start, size_t end) const {
+    bool encoded = true;
+    for (size_t i = start; i < end; i++) {
+      encoded &= set(i, in[i - start]);
+    }
+    return encoded;
+  }
+
+  // match[code] is 1 for the codes whose value pred is true for
+  template <class F> match_type match(F &&pred) const {
+    match_type match = {};
+    size_t count = dictionary_size();
+    for (size_t code = 0; code < count; code++) {
+      match[code] = pred(value(code)) ? 1 : 0;
+    }
+    return match;
+  }
+
+  // The number of rows in [start, end) whose code matches. An equality or a
+  // short IN list matches a few codes, which are counted by comparing the
+  // codes of a block with each of them, and a predicate that matches most
+  // codes is counted by its complement. The compares are vectorized, where
+  // looking each code up in match is not.
+  [[nodiscard]] size_t count_matching(const match_type &match, size_t start,
+                                      size_t end) const {
+    size_t count = dictionary_size();
+    std::array<code_type, max_compared_codes> compared;
+    size_t num_compared = 0;
+    size_t num_matching = 0;
+    for (size_t code = 0; code < count; code++) {
+      num_matching += match[code];
+    }
+    bool complement = num_matching * 2 > count;
+    for (size_t code = 0; code < count; code++) {
+      if (match[code] != complement && num_compared < max_compared_codes) {
+        compared[num_compared] = static_cast<code_type>(code);
+      }
+      num_compared += match[code] != complement;
+    }
+    if (num_compared > max_compared_codes) {
+      return count_by_lookup(match, start, end);
+    }
+    size_t compared_count = 0;
+    std::array<code_type, encoded_block_size> block = {};
+    for (size_t lo = start; lo < end;) {
+      size_t hi =
+          std::min(lo - lo % encoded_block_size + encoded_block_size, end);
+      codes().decode(lo, hi, block.data());
+      for (size_t c = 0; c < num_compared; c++) {
+        code_type code = compared[c];
+        for (size_t i = 0; i < encoded_block_size; i++) {
+          compared_count += i < hi - lo && block[i] == code;
+        }
+      }
+      lo = hi;
+    }
+    return complement ? (end - start) - compared_count : compared_count;
+  }
+
+  // adds the number of rows in [start, end) with each code to counts, which
+  // has an entry for each value in the table
+  void count_codes(size_t start, size_t end, size_t *counts) const {
+    std::array<code_type, encoded_block_size> block;
+    for (size_t lo = start; lo < end;) {
+      size_t hi =
+          std::min(lo - lo % encoded_block_size + encoded_block_size, end);
+      codes().decode(lo, hi, block.data());
+      for (size_t i = 0; i < hi - lo; i++) {
+        counts[block[i]] += 1;
+      }
+      lo = hi;
+    }
+  }
+
+private:
+  // more matching codes than this are looked up in match row by row
+  static constexpr size_t max_compared_codes = 8;
+
+  [[nodiscard]] size_t count_by_lookup(const match_type &match, size_t start,
+                                       size_t end) const {
+    std::array<code_type, encoded_block_size> block;
+    size_t count = 0;
+    for (size_t lo = start; lo < end;) {
+      size_t hi =
+          std::min(lo - lo % encoded_block_size + encoded_block_size, end);
+      codes().decode(lo, hi, block.data());
+      for (size_t i = 0; i < hi - lo; i++) {
+        count += match[block[i]];
+      }
+      lo = hi;
+    }
+    return count;
+  }
+};
+
+// A value of T which an SOA stores dictionary encoded, for columns with at
+// most MaxValues distinct values. With the default of 256 each row takes a
+// byte, and 16 values take 4 bits a row.
+template <class T, size_t MaxValues = 256> class dict {
+public:
+  using encoded_column = dict_column<T, MaxValues>;
+
+private:
+  T value = T();
+
+public:
+  constexpr dict() = default;
+  constexpr dict(const T &x) : value(x) {}
+  dict(const typename encoded_column::reference &r) : value(r) {}
+  constexpr operator T() const { return value; }
+  static std::string name() {
+    return std::string("dict<") + value_name() + ", " +
+           std::to_string(MaxValues) + ">";
+  }
+
+private:
+  // the name of T as it is written in the benchmark output
+  static std::string value_name() {
+    if constexpr (requires { T::name(); }) {
+      return T::name();
+    } else if constexpr (std::is_same_v<T, bool>) {
+      return "bool";
+    } else if constexpr (std::is_integral_v<T>) {
+      return std::string(std::is_signed_v<T> ? "int" : "uint") +
+             std::to_string(8 * sizeof(T)) + "_t";
+    } else if constexpr (std::is_same_v<T, float>) {
+      return "float";
+    } else if constexpr (std::is_same_v<T, double>) {
+      return "double";
+    } else {
+      return std::to_string(sizeof(T)) + " byte value";
+    }
+  }
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "PackedInt.hpp"
+#include "column.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// A frame of reference encoded column of uint64_t. Every block of
+// encoded_block_size rows is stored as a header holding the smallest value of
+// the block, its base, and how many rows at the start of the block have been
+// written, followed by the difference of each row from the base packed in
+// Bits bits. Blocks all take the same number of bytes, so the block of row i
+// is found directly from i and get is O(1). Rows past the written ones read
+// as zero, which is how the tail of a grown column is cleared without having
+// to fit zero into the frame.
+//
+// The values of a block must span less than 2^Bits, so the column is written
+// in bulk through encode, which frames each block as a whole, rather than a
+// row at a time. This suits timestamps, sorted ids and other columns whose
+// nearby values are close together.
+template <size_t Bits> class frame_uint_column {
+  using deltas_type = packed_uint_column<Bits>;
+
+  struct header {
+    uint64_t base;
+    uint8_t written;
+  };
+
+  static constexpr size_t header_bytes = sizeof(uint64_t) + sizeof(uint8_t);
+  static constexpr size_t deltas_bytes = encoded_block_size * Bits / 8;
+  static constexpr size_t block_bytes = header_bytes + deltas_bytes;
+  static constexpr uint64_t max_delta = (uint64_t(1) << Bits) - 1;
+
+  static_assert(encoded_block_size * Bits % 8 == 0);
+  static_assert(encoded_block_size <= UINT8_MAX);
+
+  uint8_t *data = nullptr;
+
+  [[nodiscard]] uint8_t *block(size_t b) const {
+    return data + b * block_bytes;
+  }
+
+  [[nodiscard]] header read_header(size_t b) const {
+    header h;
+    std::memcpy(&h.base, block(b), sizeof(h.base));
+    h.written = block(b)[sizeof(h.base)];
+    return h;
+  }
+
+  void write_header(size_t b, header h) const {
+    std::memcpy(block(b), &h.base, sizeof(h.base));
+    block(b)[sizeof(h.base)] = h.written;
+  }
+
+  [[nodiscard]] deltas_type deltas(size_t b) const {
+    return deltas_type(block(b) + header_bytes);
+  }
+
+public:
+  using value_type = uint64_t;
+
+  // whole blocks, and the 8 bytes of slack the packed deltas of the last block
+  // read past their end
+  static constexpr size_t bytes_for(size_t n) {
+    return (n + encoded_block_size - 1) / encoded_block_size * block_bytes + 8;
+  }
+
+  // 64 blocks are a whole number of cache lines
+  static constexpr size_t elements_per_cache_line = 64 * encoded_block_size;
+
+  frame_uint_column() = default;
+  explicit frame_uint_column(void *start)
+      : data(static_cast<uint8_t *>(start)) {}
+
+  [[nodiscard]] value_type get(size_t i) const {
+    size_t b = i / encoded_block_size;
+    size_t j = i % encoded_block_size;
+    header h = read_header(b);
+    return j < h.written ? h.base + deltas(b).get(j) : 0;
+  }
+
+  // rows are only read one at a time, they are written with encode
+  class reference {
+    frame_uint_column column;
+    size_t i;
+
+  public:
+    reference(frame_uint_column c, size_t index) : column(c), i(index) {}
+
+    operator value_type() const { return column.get(i); }
+  };
+
+  reference operator[](size_t i) const { return reference(*this, i); }
+
+  void zero_from(size_t start, size_t n) const {
+    size_t first_block = (start + encoded_block_size - 1) / encoded_block_size;
+    if (start % encoded_block_size != 0) {
+      size_t b = start / encoded_block_size;
+      header h = read_header(b);
+      h.written = std::min<size_t>(h.written, start % encoded_block_size);
+      write_header(b, h);
+    }
+    size_t first_byte = first_block * block_bytes;
+    std::memset(data + first_byte, 0, bytes_for(n) - first_byte);
+  }
+
+  void decode(size_t start, size_t end, value_type *out) const {
+    size_t b = start / encoded_block_size;
+    size_t block_start = b * encoded_block_size;
+    header h = read_header(b);
+    std::array<typename deltas_type::value_type, encoded_block_size> d;
+    deltas(b).decode(start - block_start, end - block_start, d.data());
+    size_t written = std::clamp<size_t>(h.written, start - block_start,
+                                        end - block_start) +
+                     block_start;
+    for (size_t i = start; i < written; i++) {
+      out[i - start] = h.base + d[i - start];
+    }
+    std::fill(out + (written - start), out + (end - start), 0);
+  }
+
+  // Writes in[0, end - start) to rows [start, end), which must lie in one
+  // block. The block is framed again around its written rows and the new
+  // ones, where rows before start that were never written count as zero.
+  // Returns false and leaves the block as it was if its values span 2^Bits or
+  // more.
+  bool encode(const value_type *in, size_t start, size_t end) const {
+    size_t b = start / encoded_block_size;
+    size_t block_start = b * encoded_block_size;
+    size_t lo = start - block_start;
+    size_t hi = end - block_start;
+    header h = read_header(b);
+    std::array<value_type, encoded_block_size> values;
+    if (h.written > 0) {
+      decode(block_start, block_start + h.written, values.data());
+    }
+    size_t written = std::max<size_t>(h.written, hi);
+    std::fill(values.begin() + h.written, values.begin() + written, 0);
+    std::copy(in, in + (hi - lo), values.begin() + lo);
+    auto [min, max] =
+        std::minmax_element(values.begin(), values.begin() + written);
+    if (*max - *min > max_delta) {
+      return false;
+    }
+    uint64_t base = *min;
+    deltas_type packed = deltas(b);
+    for (size_t j = 0; j < written; j++) {
+      packed.set(j, values[j] - base);
+    }
+    write_header(b, {base, static_cast<uint8_t>(written)});
+    return true;
+  }
+};
+
+// An unsigned 64 bit integer which an SOA stores frame of reference encoded,
+// as a base per block of rows and a Bits bit offset from it per row. Columns
+// of frame_uint are read through get, map_range and reduce like any other,
+// and written with SOA::assign and SOA::fill.
+template <size_t Bits> class frame_uint {
+public:
+  using encoded_column = frame_uint_column<Bits>;
+
+private:
+  uint64_t value = 0;
+
+public:
+  constexpr frame_uint() = default;
+  constexpr frame_uint(uint64_t x) : value(x) {}
+  frame_uint(const typename encoded_column::reference &r) : value(r) {}
+  constexpr operator uint64_t() const { return value; }
+  static std::string name() {
+    return std::string("frame_uint<") + std::to_string(Bits) + ">";
+  }
+};
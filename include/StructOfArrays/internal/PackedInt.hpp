@@ -0,0 +1,170 @@
+#pragma once
+
+#include "column.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// the smallest native unsigned integer that holds Bits bits
+template <size_t Bits>
+using packed_native_t = std::conditional_t<
+    Bits <= 8, uint8_t,
+    std::conditional_t<Bits <= 16, uint16_t,
+                       std::conditional_t<Bits <= 32, uint32_t, uint64_t>>>;
+
+// A column of unsigned Bits bit integers stored as one dense little endian bit
+// stream, element i in bits [i * Bits, (i + 1) * Bits). Every element is read
+// with a single unaligned 8 byte load, so the stream keeps 8 bytes of slack at
+// the end. Writes only touch the bytes the element covers, so writes to
+// elements in different cache lines can run in parallel.
+template <size_t Bits> class packed_uint_column {
+  static_assert(Bits > 0 && Bits <= 56,
+                "an element must fit in one 8 byte load at any bit offset");
+
+  uint8_t *data = nullptr;
+
+  static constexpr uint64_t mask = (uint64_t(1) << Bits) - 1;
+
+  // where each element of a group of 8 starts, relative to the first byte of
+  // the group, since 8 elements always take exactly Bits bytes
+  static constexpr std::array<uint8_t, 8> group_bytes = [] {
+    std::array<uint8_t, 8> bytes = {};
+    for (size_t j = 0; j < 8; j++) {
+      bytes[j] = j * Bits / 8;
+    }
+    return bytes;
+  }();
+  static constexpr std::array<uint8_t, 8> group_shifts = [] {
+    std::array<uint8_t, 8> shifts = {};
+    for (size_t j = 0; j < 8; j++) {
+      shifts[j] = j * Bits % 8;
+    }
+    return shifts;
+  }();
+
+public:
+  using value_type = packed_native_t<Bits>;
+
+  static constexpr size_t bytes_for(size_t n) { return (n * Bits + 7) / 8 + 8; }
+
+  // 512 elements take Bits cache lines
+  static constexpr size_t elements_per_cache_line = 512;
+
+  packed_uint_column() = default;
+  explicit packed_uint_column(void *start)
+      : data(static_cast<uint8_t *>(start)) {}
+
+  [[nodiscard]] value_type get(size_t i) const {
+    size_t bit = i * Bits;
+    uint64_t word = 0;
+    std::memcpy(&word, data + bit / 8, sizeof(word));
+    return static_cast<value_type>((word >> (bit % 8)) & mask);
+  }
+
+  void set(size_t i, uint64_t value) const {
+    size_t bit = i * Bits;
+    uint8_t *p = data + bit / 8;
+    size_t shift = bit % 8;
+    size_t num_bytes = (shift + Bits + 7) / 8;
+    uint64_t word = 0;
+    std::memcpy(&word, p, num_bytes);
+    word = (word & ~(mask << shift)) | ((value & mask) << shift);
+    std::memcpy(p, &word, num_bytes);
+  }
+
+  class reference {
+    packed_uint_column column;
+    size_t i;
+
+  public:
+    reference(packed_uint_column c, size_t index) : column(c), i(index) {}
+    reference(const reference &other) = default;
+
+    operator value_type() const { return column.get(i); }
+
+    const reference &operator=(uint64_t value) const {
+      column.set(i, value);
+      return *this;
+    }
+    // assigning one reference to another copies the value, not the reference
+    const reference &operator=(const reference &other) const {
+      return *this = uint64_t(value_type(other));
+    }
+  };
+
+  reference operator[](size_t i) const { return reference(*this, i); }
+
+  // clears the stream from the first bit of element start on, keeping the low
+  // bits of the byte it shares with element start - 1
+  void zero_from(size_t start, size_t n) const {
+    size_t bit = start * Bits;
+    size_t first_byte = bit / 8;
+    if (bit % 8 != 0) {
+      data[first_byte] &= static_cast<uint8_t>((1U << (bit % 8)) - 1);
+      first_byte++;
+    }
+    std::memset(data + first_byte, 0, bytes_for(n) - first_byte);
+  }
+
+  // Groups of 8 elements start on a byte boundary, so a block that starts on
+  // one is unpacked with the same offsets and shifts for each group. The loop
+  // has no dependencies between elements, so the loads, variable shifts and
+  // masks are vectorized.
+  void decode(size_t start, size_t end, value_type *out) const {
+    if constexpr (Bits == 8 * sizeof(value_type)) {
+      // whole native integers are already unpacked
+      std::memcpy(out, data + start * sizeof(value_type),
+                  (end - start) * sizeof(value_type));
+      return;
+    }
+    if (start % 8 != 0) {
+      for (size_t i = start; i < end; i++) {
+        *out++ = get(i);
+      }
+      return;
+    }
+    const uint8_t *p = data + start * Bits / 8;
+    size_t count = end - start;
+    size_t full_groups = count / 8;
+    for (size_t g = 0; g < full_groups; g++) {
+      for (size_t j = 0; j < 8; j++) {
+        uint64_t word = 0;
+        std::memcpy(&word, p + group_bytes[j], sizeof(word));
+        out[j] = static_cast<value_type>((word >> group_shifts[j]) & mask);
+      }
+      p += Bits;
+      out += 8;
+    }
+    for (size_t i = start + full_groups * 8; i < end; i++) {
+      *out++ = get(i);
+    }
+  }
+};
+
+// An unsigned integer of Bits bits which an SOA stores bit packed, so a
+// column of packed_uint<11> takes 11 bits per element rather than 16. Elements
+// are read and written through get, as their native type, and map_range and
+// reduce unpack a block of them at a time.
+template <size_t Bits> class packed_uint {
+public:
+  using native = packed_native_t<Bits>;
+  using encoded_column = packed_uint_column<Bits>;
+
+private:
+  native value = 0;
+
+public:
+  constexpr packed_uint() = default;
+  constexpr packed_uint(uint64_t x)
+      : value(static_cast<native>(x & ((uint64_t(1) << Bits) - 1))) {}
+  // reading an element of an SOA column gives the proxy, which converts back
+  packed_uint(const typename encoded_column::reference &r) : value(r) {}
+  constexpr operator native() const { return value; }
+  static std::string name() {
+    return std::string("packed_uint<") + std::to_string(Bits) + ">";
+  }
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../simd.hpp"
 #include <array>
 #include <concepts>
 #include <cstddef>
@@ -8,6 +9,125 @@
 #include <ostream>
 #include <string>
 #include <type_traits>
+#include <utility>
+
+template <size_t I> class sized_uint;
+
+// Converts runs of sized_uint<I>, which are I byte little endian integers
+// stored back to back, to and from the native type they are read as, one
+// vector register at a time. Each step loads a whole register of packed bytes
+// and moves the I bytes of every element to the bottom of its own lane with a
+// single byte shuffle that zeroes the rest, and encoding is the reverse
+// shuffle. Only used for the widths that are not already a native type.
+template <size_t I> struct sized_uint_codec {
+  using value_type =
+      std::conditional_t<I <= 2, std::conditional_t<I == 1, uint8_t, uint16_t>,
+                         std::conditional_t<I <= 4, uint32_t, uint64_t>>;
+
+private:
+  static constexpr size_t vector_bytes = simd_width_bytes;
+  static constexpr size_t lanes = vector_bytes / sizeof(value_type);
+  // the bytes that hold the elements of one register of lanes
+  static constexpr size_t packed_bytes = lanes * I;
+  // how far the last load of a run is moved back so that it ends at the end
+  // of the run rather than reading past it
+  static constexpr size_t skip = vector_bytes - packed_bytes;
+
+  typedef uint8_t bytes_type __attribute__((vector_size(vector_bytes)));
+
+  // Byte b of the lanes comes from this byte of the packed bytes, loaded from
+  // offset bytes before the first element. Indices from vector_bytes on select
+  // from the second operand of the shuffle, which is zero.
+  static constexpr size_t unpack_index(size_t b, size_t offset) {
+    size_t byte = b % sizeof(value_type);
+    return byte < I ? b / sizeof(value_type) * I + byte + offset
+                    : vector_bytes;
+  }
+
+  // Byte b of the packed bytes comes from this byte of the lanes. With an
+  // offset the first offset bytes are kept from the second operand, the bytes
+  // already in memory.
+  static constexpr size_t pack_index(size_t b, size_t offset) {
+    if (b < offset) {
+      return vector_bytes + b;
+    }
+    b -= offset;
+    return b < packed_bytes ? b / I * sizeof(value_type) + b % I
+                            : vector_bytes + b + offset;
+  }
+
+  template <size_t... Bs>
+  static void decode_impl(const uint8_t *p, size_t n, value_type *out,
+                          [[maybe_unused]] std::index_sequence<Bs...> bytes) {
+    bytes_type zero = {};
+    bytes_type packed;
+    bytes_type unpacked;
+    size_t j = 0;
+    for (; j * I + vector_bytes <= n * I; j += lanes) {
+      std::memcpy(&packed, p + j * I, vector_bytes);
+      unpacked = __builtin_shufflevector(packed, zero, unpack_index(Bs, 0)...);
+      std::memcpy(out + j, &unpacked, vector_bytes);
+    }
+    if (j + lanes <= n && (j + lanes) * I >= vector_bytes) {
+      std::memcpy(&packed, p + (j + lanes) * I - vector_bytes, vector_bytes);
+      unpacked =
+          __builtin_shufflevector(packed, zero, unpack_index(Bs, skip)...);
+      std::memcpy(out + j, &unpacked, vector_bytes);
+      j += lanes;
+    }
+    for (; j < n; j++) {
+      uint64_t x = 0;
+      std::memcpy(&x, p + j * I, I);
+      out[j] = x;
+    }
+  }
+
+  template <size_t... Bs>
+  static void encode_impl(const value_type *in, size_t n, uint8_t *p,
+                          [[maybe_unused]] std::index_sequence<Bs...> bytes) {
+    bytes_type unpacked;
+    bytes_type existing;
+    bytes_type packed;
+    size_t j = 0;
+    // every store stays inside the run, and the bytes it covers past its own
+    // elements are written back as they were
+    for (; j * I + vector_bytes <= n * I; j += lanes) {
+      std::memcpy(&unpacked, in + j, vector_bytes);
+      std::memcpy(&existing, p + j * I, vector_bytes);
+      packed =
+          __builtin_shufflevector(unpacked, existing, pack_index(Bs, 0)...);
+      std::memcpy(p + j * I, &packed, vector_bytes);
+    }
+    if (j + lanes <= n && (j + lanes) * I >= vector_bytes) {
+      uint8_t *q = p + (j + lanes) * I - vector_bytes;
+      std::memcpy(&unpacked, in + j, vector_bytes);
+      std::memcpy(&existing, q, vector_bytes);
+      packed =
+          __builtin_shufflevector(unpacked, existing, pack_index(Bs, skip)...);
+      std::memcpy(q, &packed, vector_bytes);
+      j += lanes;
+    }
+    for (; j < n; j++) {
+      uint64_t x = in[j];
+      std::memcpy(p + j * I, &x, I);
+    }
+  }
+
+public:
+  // writes elements [start, end) of column to out
+  static void decode(const sized_uint<I> *column, size_t start, size_t end,
+                     value_type *out) {
+    decode_impl(reinterpret_cast<const uint8_t *>(column + start), end - start,
+                out, std::make_index_sequence<vector_bytes>());
+  }
+
+  // writes in[0, end - start) to elements [start, end) of column
+  static void encode(const value_type *in, size_t start, size_t end,
+                     sized_uint<I> *column) {
+    encode_impl(in, end - start, reinterpret_cast<uint8_t *>(column + start),
+                std::make_index_sequence<vector_bytes>());
+  }
+};
 
 template <size_t I> class __attribute__((__packed__)) sized_uint {
   static_assert(I <= 8);
@@ -34,6 +154,10 @@ template <size_t I> class __attribute__((__packed__)) sized_uint {
   }
 
 public:
+  // the widths that are already a native type are read in place
+  using block_codec =
+      std::conditional_t<(I & (I - 1)) == 0, void, sized_uint_codec<I>>;
+
   constexpr sized_uint(uint64_t e) { std::memcpy(data.data(), &e, I); }
   template <size_t J> constexpr sized_uint(const sized_uint<J> &e) {
     auto el = e.get();
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+
+// the number of rows map_range and reduce decode at a time from encoded
+// columns
+inline constexpr size_t encoded_block_size = 64;
+
+// By default BasicSOA stores a column of T as a plain array of T. A type can
+// instead have its column stored encoded by naming
+//   using encoded_column = C;
+// where C is a small copyable handle over the bytes of the column with
+//   using value_type = ...;  the native type the elements are read as
+//   static constexpr size_t bytes_for(size_t n);
+//     the bytes taken by n elements. The first n elements of a longer column
+//     must take the same bytes, so a column can be grown by copying bytes.
+//   static constexpr size_t elements_per_cache_line;
+//     a number of elements that always ends on a cache line boundary
+//   C(); explicit C(void *start);
+//     a handle to nothing, as an empty container has, and one to a column
+//   reference operator[](size_t i) const;
+//     a proxy that reads as value_type, which T must be implicitly
+//     constructible from. It can be assigned to unless the column is only
+//     written in bulk, with
+//   bool encode(const value_type *in, size_t start, size_t end) const;
+//     which writes in[0, end - start) to elements [start, end), a range
+//     within one block as for decode, and returns false if they cannot be
+//     represented.
+//   void decode(size_t start, size_t end, value_type *out) const;
+//     writes elements [start, end) to out, where the range is at most
+//     encoded_block_size long and does not cross a multiple of it.
+//   void zero_from(size_t start, size_t n) const;
+//     sets elements [start, n) of a column of n elements to zero.
+// Elements of an encoded column have no address of their own, so it only
+// works with the operations that go through get, map_range and reduce. An
+// all zero column must read as zeros and T must be trivially copyable.
+template <class T>
+concept EncodedColumn = requires { typename T::encoded_column; };
+
+// An encoded column whose values all come from a small table, such as
+// dict_column, can also give count_if and value_counts the table, so they
+// evaluate predicates once per value and then read only the codes of the rows:
+//   size_t dictionary_size() const;  the number of values in the table
+//   value_type value(size_t code) const;
+//   match_type match(F &&pred) const;  which codes pred is true for
+//   size_t count_matching(const match_type &match, size_t start,
+//                         size_t end) const;
+//   void count_codes(size_t start, size_t end, size_t *counts) const;
+//     adds the number of rows in [start, end) with each code to counts
+template <class C>
+concept DictionaryColumn = requires(const C column, size_t *counts) {
+  typename C::match_type;
+  { column.dictionary_size() } -> std::same_as<size_t>;
+  column.value(size_t());
+  column.count_codes(size_t(), size_t(), counts);
+};
+
+// An encoded column of flags stored as a bitmap, such as bit_column, answers
+// SOA::count, any, all and find_next over [start, end) a word at a time, and
+// map_range_where visits only its set rows:
+//   size_t count(size_t start, size_t end) const;
+//   bool any(size_t start, size_t end) const;
+//   bool all(size_t start, size_t end) const;
+//   size_t find_next(size_t start, size_t end) const;  end if there is none
+//   void for_each_set(size_t start, size_t end, F &&f) const;
+//     calls f(i) for each set row i in order
+template <class C>
+concept BitColumn = requires(const C column) {
+  { column.count(size_t(), size_t()) } -> std::same_as<size_t>;
+  { column.any(size_t(), size_t()) } -> std::same_as<bool>;
+  { column.all(size_t(), size_t()) } -> std::same_as<bool>;
+  { column.find_next(size_t(), size_t()) } -> std::same_as<size_t>;
+  column.for_each_set(size_t(), size_t(), [](size_t) {});
+};
+
+template <class C>
+concept BulkEncodedColumn =
+    requires(const C column, const typename C::value_type *in) {
+      { column.encode(in, size_t(), size_t()) } -> std::same_as<bool>;
+    };
+
+// A type whose column stays a plain array of T can still have it read in
+// bulk by naming
+//   using block_codec = D;
+// where D has
+//   using value_type = ...;  the native type the elements are read as
+//   static void decode(const T *column, size_t start, size_t end,
+//                      value_type *out);
+//   static void encode(const value_type *in, size_t start, size_t end,
+//                      T *column);
+// map_range and reduce then decode blocks of the column when f takes its
+// arguments by value or const reference, and assign and fill encode. Naming
+// void as the codec leaves the column read in place.
+template <class T>
+concept CodecColumn = !EncodedColumn<T> &&
+                      requires { typename T::block_codec::value_type; };
+
+template <class T> struct column_traits {
+  using pointer = T *;
+  using value_type = T;
+
+  // whether the reader hands out the elements themselves
+  static constexpr bool read_in_place = true;
+
+  static constexpr size_t bytes_for(size_t n) { return n * sizeof(T); }
+
+  static constexpr size_t elements_per_cache_line =
+      elements_per_cache_line_boundary<T>();
+
+  static pointer make(void *start) { return static_cast<T *>(start); }
+
+  // plain columns are read in place, so f can write through the references
+  // map_range gives it
+  struct reader {
+    T *p;
+
+    explicit reader(T *column) : p(column) {}
+    void load([[maybe_unused]] size_t start, [[maybe_unused]] size_t end) {}
+    T &operator[](size_t i) const { return p[i]; }
+  };
+};
+
+template <EncodedColumn T> struct column_traits<T> {
+  using pointer = typename T::encoded_column;
+  using value_type = typename pointer::value_type;
+
+  static constexpr bool read_in_place = false;
+
+  static constexpr size_t bytes_for(size_t n) { return pointer::bytes_for(n); }
+
+  static constexpr size_t elements_per_cache_line =
+      std::max(pointer::elements_per_cache_line, encoded_block_size);
+
+  static pointer make(void *start) { return pointer(start); }
+
+  // decodes a block at a time, the values given to f are copies
+  struct reader {
+    pointer column;
+    size_t block_start = 0;
+    std::array<value_type, encoded_block_size> values;
+
+    explicit reader(pointer c) : column(c) {}
+    void load(size_t start, size_t end) {
+      block_start = start;
+      column.decode(start, end, values.data());
+    }
+    const value_type &operator[](size_t i) const {
+      return values[i - block_start];
+    }
+  };
+};
+
+template <CodecColumn T> struct column_traits<T> {
+  using pointer = T *;
+  using codec = typename T::block_codec;
+  using value_type = typename codec::value_type;
+
+  static constexpr bool read_in_place = false;
+
+  static constexpr size_t bytes_for(size_t n) { return n * sizeof(T); }
+
+  static constexpr size_t elements_per_cache_line =
+      elements_per_cache_line_boundary<T>();
+
+  static pointer make(void *start) { return static_cast<T *>(start); }
+
+  struct reader {
+    T *column;
+    size_t block_start = 0;
+    std::array<value_type, encoded_block_size> values;
+
+    explicit reader(T *c) : column(c) {}
+    void load(size_t start, size_t end) {
+      block_start = start;
+      codec::decode(column, start, end, values.data());
+    }
+    const value_type &operator[](size_t i) const {
+      return values[i - block_start];
+    }
+  };
+};
+
+template <class T> using column_pointer_t = typename column_traits<T>::pointer;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// The start of a file written by BasicSOA::save, at offset 0. It is followed
+// by one SavedSOAColumn for every column, and then the columns themselves,
+// each one contiguous extent of num_elements elements at the offset from the
+// start of the file its entry gives.
+// Everything is stored in the byte order of the machine that wrote the file.
+struct SavedSOAHeader {
+  static constexpr uint64_t expected_magic = 0x313056414d414f53; // "SOAMAV01"
+  static constexpr uint64_t current_version = 1;
+
+  uint64_t magic;
+  uint64_t version;
+  uint64_t num_types;
+  uint64_t num_elements;
+};
+
+struct SavedSOAColumn {
+  uint64_t size;
+  uint64_t alignment;
+  uint64_t offset;
+};
+
+// moves iov past done bytes that have already been transferred, dropping the
+// entries that are finished
+inline void advance_iovecs(iovec *&iov, size_t &count, size_t done) {
+  while (count > 0 && done >= iov->iov_len) {
+    done -= iov->iov_len;
+    iov++;
+    count--;
+  }
+  if (count > 0) {
+    iov->iov_base = static_cast<char *>(iov->iov_base) + done;
+    iov->iov_len -= done;
+  }
+}
+
+// Writes all of iov[0, count) to fd starting at offset with pwritev, carrying
+// on after short writes and interrupts. The position of fd is not used or
+// moved. iov is used as scratch.
+inline bool write_all_at(int fd, iovec *iov, size_t count, off_t offset) {
+  while (count > 0) {
+    ssize_t done = pwritev(
+        fd, iov, static_cast<int>(std::min<size_t>(count, IOV_MAX)), offset);
+    if (done < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    offset += done;
+    advance_iovecs(iov, count, done);
+  }
+  return true;
+}
+
+// Fills all of iov[0, count) from fd starting at offset with preadv, carrying
+// on after short reads and interrupts. Fails if the file ends first. iov is
+// used as scratch.
+inline bool read_all_at(int fd, iovec *iov, size_t count, off_t offset) {
+  // empty entries would otherwise look like the end of the file
+  advance_iovecs(iov, count, 0);
+  while (count > 0) {
+    ssize_t done = preadv(
+        fd, iov, static_cast<int>(std::min<size_t>(count, IOV_MAX)), offset);
+    if (done < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    if (done == 0) {
+      return false;
+    }
+    offset += done;
+    advance_iovecs(iov, count, done);
+  }
+  return true;
+}
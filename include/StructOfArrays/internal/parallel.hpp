@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if CILK == 1
+#include <cilk/cilk.h>
+#include <cilk/cilk_api.h>
+#endif
+
+// A fixed set of worker threads used for the parallel algorithms when we are
+// not building with OpenCilk. The thread that calls run takes part in the
+// work, so a pool of p workers has p - 1 threads of its own. Calls to run from
+// inside a task are run serially on the calling thread, and calls from
+// different threads of the program take turns with the whole pool.
+class ThreadPool {
+  std::vector<std::thread> threads;
+  // held by the thread that owns the pool for the whole of a run
+  std::mutex run_lock;
+  std::mutex lock;
+  std::condition_variable work_ready;
+  std::condition_variable work_done;
+
+  // the current job, tasks are handed out by incrementing next_task
+  std::function<void(size_t)> const *job = nullptr;
+  size_t num_tasks = 0;
+  std::atomic<size_t> next_task = 0;
+  size_t threads_finished = 0;
+  uint64_t generation = 0;
+  bool stopping = false;
+
+  static bool &in_worker() {
+    static thread_local bool worker = false;
+    return worker;
+  }
+
+  void run_tasks() {
+    for (size_t task = next_task.fetch_add(1); task < num_tasks;
+         task = next_task.fetch_add(1)) {
+      (*job)(task);
+    }
+  }
+
+  void worker_loop() {
+    in_worker() = true;
+    uint64_t seen_generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        work_ready.wait(guard, [&] {
+          return stopping || generation != seen_generation;
+        });
+        if (stopping) {
+          return;
+        }
+        seen_generation = generation;
+      }
+      run_tasks();
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        threads_finished += 1;
+      }
+      work_done.notify_one();
+    }
+  }
+
+  void start(size_t num_workers) {
+    stopping = false;
+    for (size_t i = 1; i < num_workers; i++) {
+      threads.emplace_back([this] { worker_loop(); });
+    }
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    threads.clear();
+  }
+
+  static size_t default_num_workers() {
+    if (const char *env = std::getenv("SOA_NUM_WORKERS")) {
+      return std::max(1L, std::strtol(env, nullptr, 10));
+    }
+    return std::max(1U, std::thread::hardware_concurrency());
+  }
+
+public:
+  explicit ThreadPool(size_t num_workers) { start(num_workers); }
+  ~ThreadPool() { stop(); }
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // the pool used by all of the containers, sized by SOA_NUM_WORKERS or the
+  // number of hardware threads
+  static ThreadPool &get() {
+    static ThreadPool pool(default_num_workers());
+    return pool;
+  }
+
+  [[nodiscard]] size_t num_workers() const { return threads.size() + 1; }
+
+  void set_num_workers(size_t num_workers) {
+    std::lock_guard<std::mutex> owner(run_lock);
+    stop();
+    start(std::max(num_workers, size_t(1)));
+  }
+
+  // calls f(i) for every i in [0, tasks) and returns once they have all
+  // finished
+  void run(size_t tasks, const std::function<void(size_t)> &f) {
+    auto run_serially = [&] {
+      for (size_t i = 0; i < tasks; i++) {
+        f(i);
+      }
+    };
+    if (tasks <= 1 || in_worker()) {
+      run_serially();
+      return;
+    }
+    std::lock_guard<std::mutex> owner(run_lock);
+    if (threads.empty()) {
+      run_serially();
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      job = &f;
+      num_tasks = tasks;
+      next_task = 0;
+      threads_finished = 0;
+      generation += 1;
+    }
+    work_ready.notify_all();
+    bool was_worker = in_worker();
+    in_worker() = true;
+    run_tasks();
+    in_worker() = was_worker;
+    std::unique_lock<std::mutex> guard(lock);
+    work_done.wait(guard, [&] { return threads_finished == threads.size(); });
+    job = nullptr;
+  }
+};
+
+[[nodiscard]] inline size_t get_num_workers() {
+#if CILK == 1
+  return __cilkrts_get_nworkers();
+#else
+  return ThreadPool::get().num_workers();
+#endif
+}
+
+// Calls f(lo, hi) over [start, end) split into chunks that line up with
+// multiples of grain, so the chunk boundaries land on the same indices no
+// matter where the range starts. Chunks may run in parallel.
+template <class F>
+void parallel_for_chunks(size_t start, size_t end, size_t grain, F &&f) {
+  if (start >= end) {
+    return;
+  }
+  grain = std::max(grain, size_t(1));
+  size_t first_chunk = start / grain;
+  size_t num_chunks = (end + grain - 1) / grain - first_chunk;
+  auto run_chunk = [&](size_t chunk) {
+    size_t lo = std::max(start, (first_chunk + chunk) * grain);
+    size_t hi = std::min(end, (first_chunk + chunk + 1) * grain);
+    f(lo, hi);
+  };
+#if CILK == 1
+  cilk_for(size_t chunk = 0; chunk < num_chunks; chunk++) { run_chunk(chunk); }
+#else
+  ThreadPool::get().run(num_chunks, run_chunk);
+#endif
+}
+
+inline constexpr size_t cache_line_size = 64;
+
+// number of elements each parallel task works on when no grain is given
+inline constexpr size_t default_parallel_grain = 1UL << 14U;
+
+// the smallest number of consecutive elements of a column of type T that
+// fills a whole number of cache lines
+template <class T> constexpr size_t elements_per_cache_line_boundary() {
+  size_t a = sizeof(T);
+  size_t b = cache_line_size;
+  while (b != 0) {
+    size_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return cache_line_size / a;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+// how many lookups ahead gather and scatter prefetch, enough misses in flight
+// to cover the latency of main memory
+inline constexpr size_t prefetch_distance = 16;
+
+template <bool Write, class E> inline void prefetch(const E *p) {
+  __builtin_prefetch(p, Write ? 1 : 0, 3);
+}
+
+// Calls visit(j) for every j in [0, n) in order, and calls prefetch(j) for
+// each j prefetch_distance steps before visit(j), so the memory for the later
+// lookups is already on its way while the current one is handled.
+template <class Prefetch, class Visit>
+void for_each_prefetched(size_t n, Prefetch &&prefetch, Visit &&visit) {
+  for (size_t j = 0; j < n && j < prefetch_distance; j++) {
+    prefetch(j);
+  }
+  size_t j = 0;
+  for (; j + prefetch_distance < n; j++) {
+    prefetch(j + prefetch_distance);
+    visit(j);
+  }
+  for (; j < n; j++) {
+    visit(j);
+  }
+}
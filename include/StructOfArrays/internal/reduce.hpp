@@ -0,0 +1,87 @@
+#pragma once
+
+#include "parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// number of independent accumulators used by reduce_range, enough to fill an
+// AVX-512 register with 64 bit lanes and to hide the latency of the combine
+inline constexpr size_t reduce_lanes = 8;
+
+// the native type a column is read as, so sized_uint<3> is read as uint32_t
+template <class T>
+using native_value_t =
+    std::conditional_t<std::is_arithmetic_v<T>, T,
+                       std::decay_t<decltype(+std::declval<const T &>())>>;
+
+// the type used to sum a column without overflowing
+template <class T>
+using sum_value_t = std::conditional_t<
+    std::is_floating_point_v<native_value_t<T>>, double,
+    std::conditional_t<std::is_signed_v<native_value_t<T>>, int64_t,
+                       uint64_t>>;
+
+// Combines element(i) for every i in [start, end). The elements are spread
+// round robin over reduce_lanes accumulators, so there is no dependency from
+// one element to the next and the loop can be unrolled and vectorized.
+// identity must be the identity of combine and combine must be associative
+// and commutative.
+template <class R, class Element, class Combine>
+R reduce_range(size_t start, size_t end, R identity, Element &&element,
+               Combine &&combine) {
+  std::array<R, reduce_lanes> accumulators;
+  accumulators.fill(identity);
+  size_t i = start;
+  for (; i + reduce_lanes <= end; i += reduce_lanes) {
+    for (size_t j = 0; j < reduce_lanes; j++) {
+      accumulators[j] = combine(accumulators[j], element(i + j));
+    }
+  }
+  for (; i < end; i++) {
+    accumulators[0] = combine(accumulators[0], element(i));
+  }
+  R result = identity;
+  for (const auto &accumulator : accumulators) {
+    result = combine(result, accumulator);
+  }
+  return result;
+}
+
+// Combines reduce_chunk(lo, hi) over chunks of grain elements that cover
+// [start, end). The chunks are reduced on their own, possibly in parallel, and
+// the per chunk partials are combined at the end.
+template <class R, class ReduceChunk, class Combine>
+R parallel_reduce_chunks(size_t start, size_t end, size_t grain, R identity,
+                         ReduceChunk &&reduce_chunk, Combine &&combine) {
+  if (start >= end) {
+    return identity;
+  }
+  grain = std::max(grain, size_t(1));
+  size_t first_chunk = start / grain;
+  std::vector<R> partials((end + grain - 1) / grain - first_chunk, identity);
+  parallel_for_chunks(start, end, grain, [&](size_t lo, size_t hi) {
+    partials[lo / grain - first_chunk] = reduce_chunk(lo, hi);
+  });
+  R result = identity;
+  for (const auto &partial : partials) {
+    result = combine(result, partial);
+  }
+  return result;
+}
+
+// Like reduce_range, but each chunk of grain elements is reduced on its own,
+// possibly in parallel, and the per chunk partials are combined at the end.
+template <class R, class Element, class Combine>
+R parallel_reduce_range(size_t start, size_t end, size_t grain, R identity,
+                        Element &&element, Combine &&combine) {
+  return parallel_reduce_chunks(
+      start, end, grain, identity,
+      [&](size_t lo, size_t hi) {
+        return reduce_range(lo, hi, identity, element, combine);
+      },
+      combine);
+}
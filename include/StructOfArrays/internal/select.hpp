@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Copies the elements of src[0, n) whose keep byte is Kept, in order, to the
+// front of dest and returns how many there were. Every element is stored at
+// the next output position, which only moves past the selected ones, so the
+// loop has no branch on keep. Stopping after the last selected element means
+// nothing is written past the selected elements. dest may be src itself.
+template <bool Kept = true, class E>
+size_t compress_store(const E *src, const uint8_t *keep, size_t n, E *dest) {
+  constexpr uint8_t flip = Kept ? 0 : 1;
+  while (n > 0 && (keep[n - 1] ^ flip) == 0) {
+    n -= 1;
+  }
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    dest[count] = src[i];
+    count += keep[i] ^ flip;
+  }
+  return count;
+}
+
+// Copies the elements of src[0, n) whose keep byte is 1 to kept and the rest
+// to rest, both in their original order, with one compress pass for each.
+template <class E>
+void partition_store(const E *src, const uint8_t *keep, size_t n, E *kept,
+                     E *rest) {
+  compress_store<true>(src, keep, n, kept);
+  compress_store<false>(src, keep, n, rest);
+}
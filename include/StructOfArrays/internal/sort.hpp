@@ -0,0 +1,162 @@
+#pragma once
+
+#include "parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// the type the keys of a column of T are sorted as, types such as sized_uint
+// that read as a native integer are sorted as that integer so that the
+// comparisons and moves during the sort are on plain registers
+template <class T> struct sort_key {
+  using type = T;
+};
+
+template <class T>
+  requires(!std::is_arithmetic_v<T> && requires(const T &x) {
+    { +x } -> std::integral;
+  })
+struct sort_key<T> {
+  using type = std::decay_t<decltype(+std::declval<const T &>())>;
+};
+
+template <class T> using sort_key_t = typename sort_key<T>::type;
+
+// Sorts [begin, end) with comp. Chunks of grain elements are sorted in
+// parallel, then neighbouring sorted runs are merged pairwise through a buffer,
+// with the merges of each round running in parallel. With Stable equal
+// elements keep their original order, since std::merge takes from the left run
+// first on ties.
+template <bool Stable, class It, class Compare>
+void parallel_sort(It begin, It end, Compare comp,
+                   size_t grain = default_parallel_grain) {
+  using E = typename std::iterator_traits<It>::value_type;
+  size_t n = end - begin;
+  grain = std::max(grain, size_t(1));
+  parallel_for_chunks(0, n, grain, [&](size_t lo, size_t hi) {
+    if constexpr (Stable) {
+      std::stable_sort(begin + lo, begin + hi, comp);
+    } else {
+      std::sort(begin + lo, begin + hi, comp);
+    }
+  });
+  if (n <= grain) {
+    return;
+  }
+
+  std::vector<E> buffer(n);
+  bool in_buffer = false;
+  for (size_t width = grain; width < n; width *= 2) {
+    size_t num_merges = (n + 2 * width - 1) / (2 * width);
+    auto merge_runs = [&](auto src, auto dest) {
+      parallel_for_chunks(0, num_merges, 1, [&](size_t lo, size_t hi) {
+        for (size_t merge = lo; merge < hi; merge++) {
+          size_t left = merge * 2 * width;
+          size_t middle = std::min(left + width, n);
+          size_t right = std::min(left + 2 * width, n);
+          std::merge(std::make_move_iterator(src + left),
+                     std::make_move_iterator(src + middle),
+                     std::make_move_iterator(src + middle),
+                     std::make_move_iterator(src + right), dest + left, comp);
+        }
+      });
+    };
+    if (in_buffer) {
+      merge_runs(buffer.begin(), begin);
+    } else {
+      merge_runs(begin, buffer.begin());
+    }
+    in_buffer = !in_buffer;
+  }
+  if (in_buffer) {
+    parallel_for_chunks(0, n, grain, [&](size_t lo, size_t hi) {
+      std::move(buffer.begin() + lo, buffer.begin() + hi, begin + lo);
+    });
+  }
+}
+
+// maps an integer key to an unsigned one that sorts in the same order
+template <class K> auto radix_key(K key) {
+  using U = std::make_unsigned_t<K>;
+  if constexpr (std::is_signed_v<K>) {
+    return U(U(key) ^ (U(1) << (sizeof(K) * 8 - 1)));
+  } else {
+    return U(key);
+  }
+}
+
+// Stable least significant digit radix sort of data by key_of(element), which
+// must return an unsigned integer of which only the low Bytes bytes are used.
+// Each pass counts the digits of every chunk of grain elements, a prefix sum
+// over the counts in digit then chunk order gives each chunk where to write
+// each digit, and then the chunks scatter into a buffer. With Parallel the
+// chunks are counted and scattered in parallel, otherwise the whole range is a
+// single chunk. Passes where every element has the same digit are skipped.
+template <size_t Bytes, bool Parallel, class E, class KeyOf>
+void radix_sort(std::vector<E> &data, KeyOf &&key_of,
+                size_t grain = default_parallel_grain) {
+  constexpr size_t radix = 256;
+  size_t n = data.size();
+  if (n <= 1) {
+    return;
+  }
+  if constexpr (Parallel) {
+    // every chunk keeps its own counts, so the number of chunks is kept to a
+    // few per worker
+    size_t max_chunks = get_num_workers() * 8;
+    grain = std::max({grain, (n + max_chunks - 1) / max_chunks, size_t(1)});
+  } else {
+    grain = n;
+  }
+  size_t num_chunks = (n + grain - 1) / grain;
+  std::vector<std::array<size_t, radix>> counts(num_chunks);
+  std::vector<E> buffer(n);
+  auto for_each_chunk = [&](auto &&f) {
+    if constexpr (Parallel) {
+      parallel_for_chunks(0, n, grain, f);
+    } else {
+      f(0, n);
+    }
+  };
+
+  for (size_t byte = 0; byte < Bytes; byte++) {
+    size_t shift = byte * 8;
+    auto digit = [&](const E &e) -> size_t {
+      return (key_of(e) >> shift) & (radix - 1);
+    };
+    for_each_chunk([&](size_t lo, size_t hi) {
+      auto &count = counts[lo / grain];
+      count.fill(0);
+      for (size_t i = lo; i < hi; i++) {
+        count[digit(data[i])] += 1;
+      }
+    });
+    size_t total = 0;
+    bool one_digit = false;
+    for (size_t d = 0; d < radix; d++) {
+      size_t digit_total = 0;
+      for (auto &count : counts) {
+        size_t c = count[d];
+        count[d] = total;
+        total += c;
+        digit_total += c;
+      }
+      one_digit = one_digit || digit_total == n;
+    }
+    if (one_digit) {
+      continue;
+    }
+    for_each_chunk([&](size_t lo, size_t hi) {
+      auto &offset = counts[lo / grain];
+      for (size_t i = lo; i < hi; i++) {
+        buffer[offset[digit(data[i])]++] = std::move(data[i]);
+      }
+    });
+    data.swap(buffer);
+  }
+}
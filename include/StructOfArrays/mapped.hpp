@@ -0,0 +1,368 @@
+#pragma once
+
+#include "soa.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <optional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+// how a MappedSOA maps its file
+enum class MapMode {
+  // shared and read only, only the const view of the soa may be used
+  read_only,
+  // shared, writes go back to the file
+  read_write,
+  // private, writes are seen by this mapping only and never reach the file
+  copy_on_write,
+};
+
+// The start of a MappedSOA file. It is followed by num_types pairs of
+// (size, alignment) for the columns, and the columns themselves start at
+// data_offset laid out exactly as BasicSOA::get_size_static describes for
+// num_spots spots. Everything is stored in the byte order of the machine that
+// wrote the file.
+struct MappedSOAHeader {
+  static constexpr uint64_t expected_magic = 0x313050414d414f53; // "SOAMAP01"
+  static constexpr uint64_t current_version = 1;
+
+  uint64_t magic;
+  uint64_t version;
+  uint64_t num_types;
+  uint64_t num_elements;
+  uint64_t num_spots;
+  uint64_t data_offset;
+  uint64_t layout_hash;
+};
+
+// A BasicSOA whose columns live in a file that is mmap'd, so a table written
+// once can be opened again by later processes and used straight away without
+// parsing or copying anything. The capacity is fixed when the file is created,
+// elements can be added with push_back up to capacity() and the current size is
+// written back to the header by sync() and when a read_write mapping is closed.
+// All the types must be trivially copyable since their bytes are the file.
+template <typename Layout, typename... Ts> class BasicMappedSOA {
+  static_assert((std::is_trivially_copyable_v<Ts> && ...),
+                "the columns of a mapped SOA are stored as raw bytes");
+  static_assert((!EncodedColumn<Ts> && ...),
+                "the file header only describes plain columns");
+
+  // the memory belongs to the mapping, so the soa never frees it, and it
+  // cannot allocate more. Nothing outside this class can reach the soa to
+  // grow it, and anything inside that did would stop the program rather than
+  // write through a null array.
+  struct MappingAllocator {
+    void *allocate([[maybe_unused]] size_t bytes,
+                   [[maybe_unused]] size_t alignment) {
+      std::fputs("a mapped SOA cannot allocate\n", stderr);
+      std::abort();
+    }
+    void deallocate([[maybe_unused]] void *p, [[maybe_unused]] size_t bytes,
+                    [[maybe_unused]] size_t alignment) {}
+  };
+
+public:
+  using SOAType = BasicSOA<Layout, MappingAllocator, Ts...>;
+
+private:
+  static constexpr size_t num_types = sizeof...(Ts);
+
+  // one (size, alignment) pair per column, written after the header
+  using TypeTable = std::array<uint64_t, 2 * num_types>;
+  static constexpr TypeTable type_table = [] {
+    TypeTable table = {};
+    size_t i = 0;
+    ((table[i++] = sizeof(Ts), table[i++] = alignof(Ts)), ...);
+    return table;
+  }();
+
+  // FNV-1a over everything that decides where the bytes of the columns are
+  static constexpr uint64_t layout_hash = [] {
+    uint64_t hash = 0xcbf29ce484222325;
+    auto add = [&](uint64_t x) {
+      for (size_t byte = 0; byte < 8; byte++) {
+        hash ^= (x >> (byte * 8)) & 0xFF;
+        hash *= 0x100000001b3;
+      }
+    };
+    add(num_types);
+    for (uint64_t x : type_table) {
+      add(x);
+    }
+    add(Layout::alignment);
+    add(Layout::tail_padding);
+    return hash;
+  }();
+
+  // the columns start on a page boundary so that each mapping of the file
+  // keeps their alignment and the pages of the header are never shared with
+  // them
+  static size_t data_offset_for_page(size_t page_size) {
+    size_t alignment =
+        std::max({page_size, Layout::alignment, alignof(Ts)...});
+    size_t header_bytes = sizeof(MappedSOAHeader) + sizeof(TypeTable);
+    return (header_bytes + alignment - 1) / alignment * alignment;
+  }
+
+  void *mapping = nullptr;
+  size_t mapping_length = 0;
+  MapMode mode = MapMode::read_only;
+  const char *error_message = nullptr;
+  std::optional<SOAType> array;
+
+  MappedSOAHeader *header() const {
+    return static_cast<MappedSOAHeader *>(mapping);
+  }
+
+  bool fail(const char *message) {
+    close();
+    error_message = message;
+    return false;
+  }
+
+  template <size_t... Is>
+  void advise_impl(int advice, std::integer_sequence<size_t, Is...>) const {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    auto advise_column = [&](auto column) {
+      uintptr_t start = reinterpret_cast<uintptr_t>(column.data());
+      uintptr_t end = start + column.size_bytes();
+      start &= ~(page_size - 1);
+      if (end > start) {
+        madvise(reinterpret_cast<void *>(start), end - start, advice);
+      }
+    };
+    (advise_column(std::as_const(*array).template column<Is>()), ...);
+  }
+
+public:
+  BasicMappedSOA() = default;
+  BasicMappedSOA(const BasicMappedSOA &) = delete;
+  BasicMappedSOA &operator=(const BasicMappedSOA &) = delete;
+  ~BasicMappedSOA() { close(); }
+
+  // Creates (or truncates) the file at path with room for capacity elements,
+  // of which the first n are in use, and maps it read_write. New files are
+  // zero filled. Returns false and sets error() on failure.
+  bool create(const char *path, size_t n, size_t capacity) {
+    close();
+    capacity = std::max(capacity, n);
+    size_t data_offset = data_offset_for_page(sysconf(_SC_PAGESIZE));
+    size_t length = data_offset + SOAType::get_size_static(capacity);
+    int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return fail("could not create the file");
+    }
+    if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+      ::close(fd);
+      return fail("could not size the file");
+    }
+    mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      return fail("could not map the file");
+    }
+    mapping_length = length;
+    mode = MapMode::read_write;
+    *header() = {MappedSOAHeader::expected_magic,
+                 MappedSOAHeader::current_version,
+                 num_types,
+                 n,
+                 capacity,
+                 data_offset,
+                 layout_hash};
+    std::memcpy(header() + 1, type_table.data(), sizeof(TypeTable));
+    array.emplace(static_cast<char *>(mapping) + data_offset, capacity, n);
+    return true;
+  }
+  bool create(const char *path, size_t n) { return create(path, n, n); }
+
+  // Maps an existing file written by create. The header is checked against
+  // the types and Layout of this class, and nothing else is read, so the
+  // columns are paged in lazily as they are used. Returns false and sets
+  // error() if the file cannot be opened or was written for another layout.
+  bool open(const char *path, MapMode open_mode = MapMode::read_only) {
+    close();
+    int fd = ::open(path, open_mode == MapMode::read_write ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+      return fail("could not open the file");
+    }
+    struct stat file_stat = {};
+    if (fstat(fd, &file_stat) != 0) {
+      ::close(fd);
+      return fail("could not stat the file");
+    }
+    size_t length = file_stat.st_size;
+    if (length < sizeof(MappedSOAHeader) + sizeof(TypeTable)) {
+      ::close(fd);
+      return fail("the file is too small to hold a header");
+    }
+    int prot = open_mode == MapMode::read_only ? PROT_READ
+                                               : PROT_READ | PROT_WRITE;
+    int flags = open_mode == MapMode::copy_on_write ? MAP_PRIVATE : MAP_SHARED;
+    mapping = mmap(nullptr, length, prot, flags, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      return fail("could not map the file");
+    }
+    mapping_length = length;
+    mode = open_mode;
+
+    const MappedSOAHeader &h = *header();
+    if (h.magic != MappedSOAHeader::expected_magic) {
+      return fail("the file is not a mapped SOA");
+    }
+    if (h.version != MappedSOAHeader::current_version) {
+      return fail("the file was written by an unsupported version");
+    }
+    if (h.num_types != num_types || h.layout_hash != layout_hash ||
+        std::memcmp(header() + 1, type_table.data(), sizeof(TypeTable)) != 0) {
+      return fail("the file was written for different types or layout");
+    }
+    size_t alignment = std::max({Layout::alignment, alignof(Ts)...});
+    if (h.data_offset % alignment != 0 || h.num_elements > h.num_spots ||
+        h.data_offset > length ||
+        SOAType::get_size_static(h.num_spots) > length - h.data_offset) {
+      return fail("the header does not match the size of the file");
+    }
+    array.emplace(static_cast<char *>(mapping) + h.data_offset, h.num_spots,
+                  h.num_elements);
+    return true;
+  }
+
+  // records the current size in the header and flushes the mapping to the
+  // file, only does anything for read_write mappings
+  bool sync() {
+    if (!is_open() || mode != MapMode::read_write) {
+      return false;
+    }
+    header()->num_elements = array->size();
+    return msync(mapping, mapping_length, MS_SYNC) == 0;
+  }
+
+  // unmaps the file, the size is written back first for read_write mappings.
+  // The data itself reaches the file whenever the kernel writes the pages back,
+  // call sync() first to wait for it.
+  void close() {
+    if (mapping != nullptr) {
+      if (mode == MapMode::read_write && array) {
+        header()->num_elements = array->size();
+      }
+      array.reset();
+      munmap(mapping, mapping_length);
+    }
+    mapping = nullptr;
+    mapping_length = 0;
+    error_message = nullptr;
+  }
+
+  [[nodiscard]] bool is_open() const { return array.has_value(); }
+
+  // why the last create or open failed
+  [[nodiscard]] const char *error() const { return error_message; }
+
+  [[nodiscard]] MapMode get_mode() const { return mode; }
+
+  // A read only view of the mapped columns, for sum, reduce, count_if and the
+  // like, which must only be used while the file is open. The mapping cannot
+  // grow or be reallocated, so the rows are written only through the members
+  // below, which work in place and refuse to write to a read_only mapping.
+  auto soa() const { return std::as_const(*array).view(); }
+
+  [[nodiscard]] size_t size() const { return array->size(); }
+  [[nodiscard]] size_t capacity() const { return array->capacity(); }
+
+  [[nodiscard]] bool writable() const {
+    return is_open() && mode != MapMode::read_only;
+  }
+
+  // appends v and returns true, or returns false if the mapping is read_only
+  // or already holds capacity() rows
+  bool push_back(const typename SOAType::T &v) {
+    if (!writable() || size() == capacity()) {
+      return false;
+    }
+    array->push_back(v);
+    return true;
+  }
+
+  // writes values to the selected columns of row i, which must be below
+  // size(), and returns false if the mapping is read_only
+  template <size_t... Is, class U> bool set(size_t i, const U &values) {
+    if (!writable()) {
+      return false;
+    }
+    array->template get<Is...>(i) = values;
+    return true;
+  }
+
+  // map_range and friends of the mapped columns, which may write to the rows,
+  // and return false without calling f if the mapping is read_only. Reading
+  // goes through soa().
+  template <size_t... Is, class F>
+  bool map_range(F &&f, size_t start = 0,
+                 size_t end = std::numeric_limits<size_t>::max()) {
+    if (!writable()) {
+      return false;
+    }
+    array->template map_range<Is...>(f, start, end);
+    return true;
+  }
+
+  template <size_t... Is, class F>
+  bool map_range_with_index(F &&f, size_t start = 0,
+                            size_t end = std::numeric_limits<size_t>::max()) {
+    if (!writable()) {
+      return false;
+    }
+    array->template map_range_with_index<Is...>(f, start, end);
+    return true;
+  }
+
+  template <size_t... Is, class F>
+  bool parallel_map_range(F &&f, size_t start = 0,
+                          size_t end = std::numeric_limits<size_t>::max(),
+                          size_t grain = default_parallel_grain) {
+    if (!writable()) {
+      return false;
+    }
+    array->template parallel_map_range<Is...>(f, start, end, grain);
+    return true;
+  }
+
+  template <size_t... Is, class F>
+  bool parallel_map_range_with_index(
+      F &&f, size_t start = 0, size_t end = std::numeric_limits<size_t>::max(),
+      size_t grain = default_parallel_grain) {
+    if (!writable()) {
+      return false;
+    }
+    array->template parallel_map_range_with_index<Is...>(f, start, end, grain);
+    return true;
+  }
+
+  // passes advice, such as MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED or
+  // MADV_DONTNEED, to madvise for the pages of columns Is, or of every column
+  // if none are given, so each column can be hinted for how it is used
+  template <size_t... Is> void advise(int advice) const {
+    if constexpr (sizeof...(Is) == 0) {
+      advise_impl(advice, std::make_index_sequence<num_types>{});
+    } else {
+      advise_impl(advice, std::integer_sequence<size_t, Is...>{});
+    }
+  }
+};
+
+template <typename... Ts>
+using MappedSOA = BasicMappedSOA<SOALayout<>, Ts...>;
@@ -0,0 +1,299 @@
+#pragma once
+
+#include "allocator.hpp"
+#include "internal/Bit.hpp"
+#include "soa.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A table kept sorted by a unique key in column 0, laid out as a packed memory
+// array: the rows are stored in order in a BasicSOA with more slots than rows,
+// and the free slots are spread through the columns so an insert only moves
+// the rows between it and a nearby gap rather than the whole tail of the table.
+// Which slots hold rows is kept in a bit column after the others.
+//
+// The slots are split into segments of 64, one word of the bitmap each, and
+// segments into windows of 2, 4, 8 ... segments up to the whole array. An
+// insert into a segment with a free slot shifts rows within the segment. An
+// insert into a full segment finds the smallest window around it that is
+// below its density limit, which goes from all of a window at the segment
+// level down to 3/4 for the whole array, and spreads the rows of that window
+// out evenly, and when the whole array is over its limit it doubles. This
+// bounds the rows moved to amortized O(log^2 n) per insert.
+//
+// Scans with map_range walk the set bits of the bitmap, so they read the
+// columns in order and skip 64 free slots with one test. Point lookups binary
+// search the key column, stepping over free slots with find_next. The columns
+// are moved with memmove, so they must be plain and trivially copyable.
+template <typename Layout, typename Allocator, typename Key, typename... Ts>
+class BasicPMA {
+  static_assert(std::is_trivially_copyable_v<Key> &&
+                    (std::is_trivially_copyable_v<Ts> && ...),
+                "rows are moved between slots with memmove");
+  static_assert(!EncodedColumn<Key> && (!EncodedColumn<Ts> && ...),
+                "rows are moved between slots with memmove");
+
+public:
+  using T = std::tuple<Key, Ts...>;
+  using SOAType = BasicSOA<Layout, Allocator, Key, Ts..., bit>;
+
+private:
+  static constexpr size_t num_columns = sizeof...(Ts) + 1;
+  // the bit column marking the slots that hold a row
+  static constexpr size_t occupied = num_columns;
+  static constexpr size_t segment_size = 64;
+  // the most of the whole array a rebalance may fill before it doubles
+  static constexpr double root_density = 0.75;
+
+  template <size_t I> using NthType = std::tuple_element_t<I, T>;
+
+  SOAType slots;
+  size_t num_elements = 0;
+  // the rows of a window while it is spread out
+  std::vector<T> scratch;
+
+  [[nodiscard]] const Key &key_at(size_t slot) const {
+    return slots.template column<0>()[slot];
+  }
+
+  [[nodiscard]] bool is_occupied(size_t slot) const {
+    return std::get<0>(slots.template get<occupied>(slot));
+  }
+
+  static void set_occupied(SOAType &dest, size_t slot, bool value) {
+    std::get<0>(dest.template get<occupied>(slot)) = value;
+  }
+
+  // the columns of slot, all but the bitmap if none are selected
+  template <size_t... Is> auto get_slot(size_t slot) const {
+    if constexpr (sizeof...(Is) == 0) {
+      return get_slot_impl(slot, std::make_index_sequence<num_columns>{});
+    } else {
+      return slots.template get<Is...>(slot);
+    }
+  }
+
+  template <size_t... Is>
+  auto get_slot_impl(size_t slot, std::index_sequence<Is...>) const {
+    return slots.template get<Is...>(slot);
+  }
+
+  template <size_t... Is>
+  static void write_slot(SOAType &dest, size_t slot, const T &row,
+                         std::index_sequence<Is...>) {
+    dest.template get<Is...>(slot) = row;
+  }
+
+  // moves rows [from, from + count) to start at to, the slots may overlap
+  template <size_t... Is>
+  void move_slots(size_t from, size_t to, size_t count,
+                  std::index_sequence<Is...>) {
+    (std::memmove(slots.template column<Is>().data() + to,
+                  slots.template column<Is>().data() + from,
+                  count * sizeof(NthType<Is>)),
+     ...);
+  }
+
+  // The first occupied slot whose key is not less than key, or capacity() if
+  // there is none. Occupied slots before lo are less than key and those from
+  // hi on are not, and the first occupied slot at or after mid decides which
+  // end moves.
+  [[nodiscard]] size_t lower_bound_slot(const Key &key) const {
+    size_t lo = 0;
+    size_t hi = slots.size();
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      size_t next = slots.template find_next<occupied>(mid, hi);
+      if (next != hi && key_at(next) < key) {
+        lo = next + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return slots.template find_next<occupied>(lo, slots.size());
+  }
+
+  // Puts row just before slot pos, or after the last row if pos is hi, the end
+  // of its segment, shifting rows over by one into the nearest free slot of the
+  // segment, which must have one.
+  void insert_in_segment(size_t pos, size_t hi, const T &row) {
+    size_t free = pos;
+    while (free < hi && is_occupied(free)) {
+      free++;
+    }
+    if (free < hi) {
+      move_slots(pos, pos + 1, free - pos,
+                 std::make_index_sequence<num_columns>{});
+    } else {
+      free = pos - 1;
+      while (is_occupied(free)) {
+        free--;
+      }
+      move_slots(free + 1, free, pos - 1 - free,
+                 std::make_index_sequence<num_columns>{});
+      pos--;
+    }
+    write_slot(slots, pos, row, std::make_index_sequence<num_columns>{});
+    set_occupied(slots, free, true);
+  }
+
+  // copies the rows of [lo, hi) to scratch in order with row among them
+  void gather(size_t lo, size_t hi, const T &row) {
+    scratch.clear();
+    bool placed = false;
+    for (size_t s = slots.template find_next<occupied>(lo, hi); s < hi;
+         s = slots.template find_next<occupied>(s + 1, hi)) {
+      if (!placed && std::get<0>(row) < key_at(s)) {
+        scratch.push_back(row);
+        placed = true;
+      }
+      scratch.push_back(T(get_slot(s)));
+    }
+    if (!placed) {
+      scratch.push_back(row);
+    }
+  }
+
+  // writes scratch to the cleared slots [lo, hi) of dest evenly spaced
+  void spread(SOAType &dest, size_t lo, size_t hi) {
+    size_t n = scratch.size();
+    for (size_t j = 0; j < n; j++) {
+      size_t slot = lo + j * (hi - lo) / n;
+      write_slot(dest, slot, scratch[j],
+                 std::make_index_sequence<num_columns>{});
+      set_occupied(dest, slot, true);
+    }
+  }
+
+  // Inserts row into the full segment holding pos by spreading out the
+  // smallest window around it that has room, or doubling the array.
+  void rebalance_insert(size_t pos, const T &row) {
+    size_t capacity = slots.size();
+    size_t height = std::countr_zero(capacity / segment_size);
+    for (size_t level = 1; level <= height; level++) {
+      size_t window = segment_size << level;
+      size_t lo = pos / window * window;
+      size_t count = slots.template count<occupied>(lo, lo + window) + 1;
+      double limit = 1.0 - (1.0 - root_density) * double(level) / height;
+      if (count <= limit * window) {
+        gather(lo, lo + window, row);
+        slots.template fill<occupied>(false, lo, lo + window);
+        spread(slots, lo, lo + window);
+        return;
+      }
+    }
+    gather(0, capacity, row);
+    SOAType grown(2 * capacity, slots.get_allocator());
+    spread(grown, 0, grown.size());
+    slots = std::move(grown);
+  }
+
+  template <size_t... Is> static constexpr auto selected_columns() {
+    if constexpr (sizeof...(Is) == 0) {
+      return std::make_index_sequence<num_columns>{};
+    } else {
+      return std::index_sequence<Is...>{};
+    }
+  }
+
+  template <class F, size_t... Is>
+  void map_range_impl(F &&f, std::index_sequence<Is...>) const {
+    slots.template map_range_where<occupied, Is...>(f);
+  }
+
+  template <class F, size_t... Is>
+  void parallel_map_range_impl(F &&f, size_t grain,
+                               std::index_sequence<Is...>) const {
+    slots.template parallel_map_range_where<occupied, Is...>(
+        f, 0, slots.size(), grain);
+  }
+
+public:
+  BasicPMA(Allocator alloc = Allocator()) : slots(alloc) {}
+
+  // the number of rows
+  [[nodiscard]] size_t size() const { return num_elements; }
+
+  [[nodiscard]] bool empty() const { return num_elements == 0; }
+
+  // the number of slots, including the free ones
+  [[nodiscard]] size_t capacity() const { return slots.size(); }
+
+  [[nodiscard]] size_t get_size() const { return slots.get_size(); }
+
+  // Inserts a row in key order and returns true, or returns false and leaves
+  // the table as it was if a row with key is already there.
+  bool insert(const Key &key, const Ts &...values) {
+    if (slots.size() == 0) {
+      slots = SOAType(segment_size, slots.get_allocator());
+    }
+    size_t pos = lower_bound_slot(key);
+    if (pos != slots.size() && !(key < key_at(pos))) {
+      return false;
+    }
+    T row(key, values...);
+    size_t lo = (pos == slots.size() ? pos - 1 : pos) / segment_size *
+                segment_size;
+    size_t hi = lo + segment_size;
+    if (slots.template count<occupied>(lo, hi) < segment_size) {
+      insert_in_segment(pos, hi, row);
+    } else {
+      rebalance_insert(lo, row);
+    }
+    num_elements++;
+    return true;
+  }
+
+  // Removes the row with key and returns whether there was one. Its slot is
+  // left free for later inserts, the array is never shrunk.
+  bool erase(const Key &key) {
+    size_t pos = lower_bound_slot(key);
+    if (pos == slots.size() || key < key_at(pos)) {
+      return false;
+    }
+    set_occupied(slots, pos, false);
+    num_elements--;
+    return true;
+  }
+
+  [[nodiscard]] bool contains(const Key &key) const {
+    size_t pos = lower_bound_slot(key);
+    return pos != slots.size() && !(key < key_at(pos));
+  }
+
+  // the selected columns of the row with key as references, which may be
+  // written except for the key, or nothing if there is no such row
+  template <size_t... Is> auto find(const Key &key) const {
+    using Row = decltype(get_slot<Is...>(0));
+    size_t pos = lower_bound_slot(key);
+    if (pos == slots.size() || key < key_at(pos)) {
+      return std::optional<Row>();
+    }
+    return std::optional<Row>(get_slot<Is...>(pos));
+  }
+
+  // Calls f with the selected columns of every row in key order, all but the
+  // bitmap if none are selected. f may write the columns other than the key.
+  template <size_t... Is, class F> void map_range(F &&f) const {
+    map_range_impl(f, selected_columns<Is...>());
+  }
+
+  template <size_t... Is, class F>
+  void parallel_map_range(F &&f, size_t grain = default_parallel_grain) const {
+    parallel_map_range_impl(f, grain, selected_columns<Is...>());
+  }
+
+  // the underlying slots, free ones included, with the bitmap as the last
+  // column
+  [[nodiscard]] const SOAType &get_slots() const { return slots; }
+};
+
+template <typename Key, typename... Ts>
+using PMA = BasicPMA<SOALayout<>, MallocAllocator, Key, Ts...>;
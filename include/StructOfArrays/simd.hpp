@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// width in bytes of the widest vector registers of the target
+#if defined(__AVX512F__)
+inline constexpr size_t simd_width_bytes = 64;
+#elif defined(__AVX__)
+inline constexpr size_t simd_width_bytes = 32;
+#else
+inline constexpr size_t simd_width_bytes = 16;
+#endif
+
+// the number of lanes to use when processing columns of these types together,
+// enough to fill one vector register with the widest of them
+template <class... Ts>
+inline constexpr size_t simd_lanes_for =
+    std::max<size_t>(simd_width_bytes / std::max({sizeof(Ts)...}), 1);
+
+// W lanes of T held in a compiler vector type, so the usual arithmetic and
+// bitwise operators on v compile to vector instructions on both gcc and clang.
+// A batch read from the end of a column may be partial, only the first active
+// lanes hold data and the rest are zero. The binary operators keep the lanes
+// past active zero, so a partial batch can be added into a full accumulator.
+template <class T, size_t W> struct simd_batch {
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>);
+  static_assert(W > 0 && (W & (W - 1)) == 0, "W must be a power of 2");
+
+  using value_type = T;
+  typedef T vector_type __attribute__((vector_size(W * sizeof(T))));
+  static constexpr size_t width = W;
+
+  vector_type v = {};
+  size_t active = W;
+
+  simd_batch() = default;
+  simd_batch(T x) : v(vector_type{} + x) {}
+  simd_batch(vector_type x, size_t active_lanes = W)
+      : v(x), active(active_lanes) {}
+
+  // reads W elements of type U starting at p, converting each to T
+  template <class U> static simd_batch load(const U *p) {
+    simd_batch batch;
+    if constexpr (std::is_same_v<T, U>) {
+      std::memcpy(&batch.v, p, sizeof(batch.v));
+    } else {
+      // converting through a plain array lets the loop be vectorized, where
+      // setting the lanes of v one at a time does not
+      T lanes[W];
+      for (size_t lane = 0; lane < W; lane++) {
+        lanes[lane] = static_cast<T>(p[lane]);
+      }
+      std::memcpy(&batch.v, lanes, sizeof(batch.v));
+    }
+    return batch;
+  }
+
+  // reads count < W elements, the remaining lanes are left as zero
+  template <class U> static simd_batch load(const U *p, size_t count) {
+    simd_batch batch;
+    batch.active = count;
+    for (size_t lane = 0; lane < count; lane++) {
+      batch.v[lane] = static_cast<T>(p[lane]);
+    }
+    return batch;
+  }
+
+  // writes the active lanes to p, converting each to U
+  template <class U> void store(U *p) const {
+    if constexpr (std::is_same_v<T, U>) {
+      if (active == W) {
+        std::memcpy(p, &v, sizeof(v));
+        return;
+      }
+    }
+    for (size_t lane = 0; lane < active; lane++) {
+      p[lane] = static_cast<U>(v[lane]);
+    }
+  }
+
+  T operator[](size_t lane) const { return v[lane]; }
+
+  [[nodiscard]] bool is_active(size_t lane) const { return lane < active; }
+
+  template <class U> simd_batch<U, W> convert() const {
+    return simd_batch<U, W>(
+        __builtin_convertvector(v, typename simd_batch<U, W>::vector_type),
+        active);
+  }
+
+  T reduce_add() const {
+    T result = 0;
+    for (size_t lane = 0; lane < active; lane++) {
+      result += v[lane];
+    }
+    return result;
+  }
+
+  T reduce_min() const {
+    T result = std::numeric_limits<T>::max();
+    for (size_t lane = 0; lane < active; lane++) {
+      result = std::min(result, T(v[lane]));
+    }
+    return result;
+  }
+
+  T reduce_max() const {
+    T result = std::numeric_limits<T>::lowest();
+    for (size_t lane = 0; lane < active; lane++) {
+      result = std::max(result, T(v[lane]));
+    }
+    return result;
+  }
+
+  // zeroes the lanes past active, which a broadcast operand sets
+  void zero_inactive() {
+    for (size_t lane = active; lane < W; lane++) {
+      v[lane] = 0;
+    }
+  }
+
+  simd_batch &operator+=(const simd_batch &rhs) {
+    v += rhs.v;
+    return *this;
+  }
+  simd_batch &operator-=(const simd_batch &rhs) {
+    v -= rhs.v;
+    return *this;
+  }
+  simd_batch &operator*=(const simd_batch &rhs) {
+    v *= rhs.v;
+    return *this;
+  }
+
+  friend simd_batch operator+(simd_batch lhs, const simd_batch &rhs) {
+    lhs.active = std::min(lhs.active, rhs.active);
+    lhs += rhs;
+    lhs.zero_inactive();
+    return lhs;
+  }
+  friend simd_batch operator-(simd_batch lhs, const simd_batch &rhs) {
+    lhs.active = std::min(lhs.active, rhs.active);
+    lhs -= rhs;
+    lhs.zero_inactive();
+    return lhs;
+  }
+  friend simd_batch operator*(simd_batch lhs, const simd_batch &rhs) {
+    lhs.active = std::min(lhs.active, rhs.active);
+    lhs *= rhs;
+    lhs.zero_inactive();
+    return lhs;
+  }
+};
@@ -1,17 +1,65 @@
 #pragma once
 
+#include "allocator.hpp"
+#include "internal/column.hpp"
+#include "internal/io.hpp"
+#include "internal/parallel.hpp"
+#include "internal/prefetch.hpp"
+#include "internal/reduce.hpp"
+#include "internal/select.hpp"
+#include "internal/sort.hpp"
 #include "multipointer.hpp"
+#include "simd.hpp"
+#include <algorithm>
 #include <array>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <ranges>
+#include <span>
+#include <sys/stat.h>
 #include <tuple>
+#include <type_traits>
+#include <unistd.h>
 #include <utility>
 #include <vector>
 
-template <typename... Ts> class SOA {
+// Controls where the columns of a BasicSOA are placed. The allocation and
+// every column start on an Alignment byte boundary (or the natural alignment of
+// the column if that is larger), so with the default every column starts on its
+// own cache line. TailPadding bytes of zeros are left after the end of each
+// column so that full width vector loads can run past the last element without
+// needing a masked load.
+template <size_t Alignment = 64, size_t TailPadding = 0> struct SOALayout {
+  static_assert(Alignment > 0 && (Alignment & (Alignment - 1)) == 0,
+                "Alignment must be a power of 2");
+  static constexpr size_t alignment = Alignment;
+  static constexpr size_t tail_padding = TailPadding;
+};
+
+template <bool ReadOnly, typename... Ts> class BasicSOAView;
+
+// a view that reads and writes the rows it covers, and one that only reads them
+template <typename... Ts> using SOAView = BasicSOAView<false, Ts...>;
+template <typename... Ts> using ConstSOAView = BasicSOAView<true, Ts...>;
+
+// Allocator is used for every allocation the container makes, see
+// allocator.hpp for what it needs to provide
+template <typename Layout, typename Allocator, typename... Ts> class BasicSOA {
+  static_assert(SOAAllocator<Allocator>);
+
+  // projections such as pull_types build a BasicSOA with different types
+  template <typename, typename, typename...> friend class BasicSOA;
+  // views run the column loops below on their own column starts
+  template <bool, typename...> friend class BasicSOAView;
+
 public:
   using T = std::tuple<Ts...>;
 
@@ -20,12 +68,130 @@ private:
   static constexpr std::array<std::size_t, num_types> alignments = {
       std::alignment_of_v<Ts>...};
 
+  // where each column is allowed to start
+  static constexpr std::array<std::size_t, num_types> column_alignments = {
+      std::max(Layout::alignment, std::alignment_of_v<Ts>)...};
+
   template <int I> using NthType = typename std::tuple_element<I, T>::type;
 
   static constexpr std::array<std::size_t, num_types> sizes = {sizeof(Ts)...};
 
+  // the bytes column i takes with num_spots spots, which is only different
+  // from num_spots * sizes[i] for encoded columns
+  static constexpr size_t column_bytes(size_t i, size_t num_spots) {
+    constexpr std::array<size_t (*)(size_t), num_types> bytes_for = {
+        &column_traits<Ts>::bytes_for...};
+    return bytes_for[i](num_spots);
+  }
+
+  // true if none of the selected columns are encoded, which the operations
+  // that need the address of each element require
+  template <size_t... Is> static constexpr bool plain_columns() {
+    if constexpr (sizeof...(Is) > 0) {
+      return (!EncodedColumn<NthType<Is>> && ...);
+    } else {
+      return (!EncodedColumn<Ts> && ...);
+    }
+  }
+
+  // what a column is passed to f as when it is read a block at a time
+  template <class T>
+  using block_argument_t =
+      std::conditional_t<column_traits<T>::read_in_place, T &,
+                         typename column_traits<T>::value_type>;
+
+  template <class F, class Index, size_t... Is>
+  static constexpr bool
+  read_by_block_impl([[maybe_unused]] std::integer_sequence<size_t, Is...>
+                         int_seq) {
+    if constexpr ((column_traits<NthType<Is>>::read_in_place && ...)) {
+      return false;
+    } else if constexpr (!plain_columns<Is...>()) {
+      return true;
+    } else if constexpr (std::is_void_v<Index>) {
+      return std::is_invocable_v<F &, block_argument_t<NthType<Is>>...>;
+    } else {
+      return std::is_invocable_v<F &, Index,
+                                 block_argument_t<NthType<Is>>...>;
+    }
+  }
+
+  // Whether f is called on the selected columns through their readers a block
+  // at a time rather than on the elements in place, with Index the type of
+  // the leading index argument if f takes one. Encoded columns are always
+  // read by block. Columns with a codec are only decoded when f can take
+  // their values, so an f that takes its arguments by non const reference
+  // still writes to the elements in place.
+  template <class F, class Index, size_t... Is>
+  static constexpr bool read_by_block() {
+    return read_by_block_impl<std::remove_reference_t<F>, Index>(
+        selected_columns<Is...>());
+  }
+
+  static constexpr size_t base_alignment =
+      std::max({Layout::alignment, std::alignment_of_v<Ts>...});
+
+  static constexpr size_t round_up(size_t x, size_t alignment) {
+    if (x % alignment != 0) {
+      x += alignment - (x % alignment);
+    }
+    return x;
+  }
+
+  // byte offset of the start of column I in a layout with num_spots spots
+  static constexpr uintptr_t column_offset_static(size_t I, size_t num_spots) {
+    uintptr_t offset = 0;
+    for (size_t i = 0; i < I; i++) {
+      offset += column_bytes(i, num_spots) + Layout::tail_padding;
+      offset = round_up(offset, column_alignments[i + 1]);
+    }
+    return offset;
+  }
+
+  // byte offset of the start of every column, in a single pass over the
+  // columns
+  static constexpr std::array<uintptr_t, num_types>
+  column_offsets_static(size_t num_spots) {
+    std::array<uintptr_t, num_types> offsets = {};
+    for (size_t i = 1; i < num_types; i++) {
+      offsets[i] = round_up(offsets[i - 1] + column_bytes(i - 1, num_spots) +
+                                Layout::tail_padding,
+                            column_alignments[i]);
+    }
+    return offsets;
+  }
+
+  // zeros the tail padding after each column
+  static void zero_padding_static(void *base_array, size_t num_spots) {
+    if constexpr (Layout::tail_padding > 0) {
+      for (size_t i = 0; i < num_types; i++) {
+        std::memset(static_cast<char *>(base_array) +
+                        column_offset_static(i, num_spots) +
+                        column_bytes(i, num_spots),
+                    0, Layout::tail_padding);
+      }
+    }
+  }
+
+  // num_spots is the capacity and determines the layout of the columns,
+  // num_elements is how many of those spots are in use
   size_t num_spots;
+  size_t num_elements;
   void *base_array;
+  // a pointer to the start of each column, or the handle of an encoded column
+  using ColumnPointers = std::tuple<column_pointer_t<Ts>...>;
+  // the start of each column of base_array, cached so that element accesses
+  // do not have to work out the column offsets again
+  ColumnPointers column_starts;
+  // mutable since allocators like a pmr resource may change state when they
+  // hand out memory, even from a const member like resize
+  [[no_unique_address]] mutable Allocator allocator;
+
+  void free_array() {
+    if (base_array != nullptr) {
+      allocator.deallocate(base_array, get_size(), base_alignment);
+    }
+  }
 
   // TODO(wheatman) properly have const and non const versions of this and
   // propogate them up
@@ -33,16 +199,9 @@ private:
   static NthType<I> *get_starting_pointer_to_type_static(void *base_array,
                                                          size_t num_spots) {
     static_assert(I < num_types);
-    uintptr_t offset = 0;
-    if constexpr (I > 0) {
-      for (size_t i = 0; i < I; i++) {
-        offset += num_spots * sizes[i];
-        if (offset % alignments[i + 1] != 0) {
-          offset += alignments[i + 1] - (offset % alignments[i + 1]);
-        }
-      }
-    }
-    return (NthType<I> *)((char *)base_array + offset);
+    static_assert(plain_columns<I>(), "encoded columns have no element type");
+    return (NthType<I> *)((char *)base_array +
+                          column_offset_static(I, num_spots));
   }
 
   template <size_t I>
@@ -50,46 +209,367 @@ private:
   get_starting_pointer_to_type_static(const void *base_array,
                                       size_t num_spots) {
     static_assert(I < num_types);
-    uintptr_t offset = 0;
-    if constexpr (I > 0) {
-      for (size_t i = 0; i < I; i++) {
-        offset += num_spots * sizes[i];
-        if (offset % alignments[i + 1] != 0) {
-          offset += alignments[i + 1] - (offset % alignments[i + 1]);
-        }
-      }
-    }
-    return (const NthType<I> *)((const char *)base_array + offset);
+    static_assert(plain_columns<I>(), "encoded columns have no element type");
+    return (const NthType<I> *)((const char *)base_array +
+                                column_offset_static(I, num_spots));
   }
 
   template <size_t I> NthType<I> *get_starting_pointer_to_type() const {
-    return get_starting_pointer_to_type_static<I>(base_array, num_spots);
+    return std::get<I>(column_starts);
+  }
+
+  // the first byte of column I, which works for encoded columns too
+  template <size_t I>
+  static char *column_bytes_start_static(void *base_array, size_t num_spots) {
+    return static_cast<char *>(base_array) + column_offset_static(I, num_spots);
+  }
+
+  template <size_t... Is>
+  static ColumnPointers column_pointers_impl_static(
+      void *base_array, size_t num_spots,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    const auto offsets = column_offsets_static(num_spots);
+    return ColumnPointers(column_traits<NthType<Is>>::make(
+        static_cast<char *>(base_array) + offsets[Is])...);
+  }
+
+  // the start of every column of a layout with num_spots spots
+  static ColumnPointers column_pointers_static(void *base_array,
+                                               size_t num_spots) {
+    if (base_array == nullptr) {
+      return ColumnPointers();
+    }
+    return column_pointers_impl_static(base_array, num_spots,
+                                       std::make_index_sequence<num_types>{});
+  }
+
+  // must be called whenever base_array or num_spots changes
+  void update_column_starts() {
+    column_starts = column_pointers_static(base_array, num_spots);
+  }
+
+  template <size_t... Is>
+  static auto get_from_columns_impl(
+      const ColumnPointers &columns, size_t i,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    // references into plain columns, and proxies by value for encoded ones
+    return std::tuple<decltype(std::get<Is>(columns)[i])...>(
+        std::get<Is>(columns)[i]...);
+  }
+
+  // like get_static, but reads from already computed column starts
+  template <size_t... Is>
+  static auto get_from_columns(const ColumnPointers &columns, size_t i) {
+    return get_from_columns_impl(columns, i, selected_columns<Is...>());
+  }
+
+  template <size_t... Is>
+  static auto get_ptr_from_columns_impl(
+      const ColumnPointers &columns, size_t i,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    return MultiPointer((std::get<Is>(columns) + i)...);
+  }
+
+  template <size_t... Is>
+  static auto get_ptr_from_columns(const ColumnPointers &columns, size_t i) {
+    static_assert(plain_columns<Is...>(),
+                  "elements of encoded columns have no address");
+    if constexpr (sizeof...(Is) == 1) {
+      return std::get<Is...>(columns) + i;
+    } else {
+      return get_ptr_from_columns_impl(columns, i, selected_columns<Is...>());
+    }
+  }
+
+  // when every column is trivially copyable the columns can be moved around
+  // as raw bytes instead of one element at a time
+  static constexpr bool trivially_copyable =
+      (std::is_trivially_copyable_v<Ts> && ...);
+
+  // true if a default constructed element of every column is all zero bytes,
+  // in which case the tail of a grown array can come straight from calloc
+  static bool default_is_zero() {
+    const T zero;
+    bool is_zero = true;
+    std::apply(
+        [&is_zero](const auto &...field) {
+          auto check = [](const auto &x) {
+            const auto *bytes = reinterpret_cast<const unsigned char *>(&x);
+            return std::all_of(bytes, bytes + sizeof(x),
+                               [](unsigned char b) { return b == 0; });
+          };
+          is_zero = (check(field) && ...);
+        },
+        zero);
+    return is_zero;
+  }
+
+  // copies the bytes of the first count elements of column I between two
+  // layouts, the old one may be empty
+  template <size_t I>
+  static void copy_column_bytes_static(void *new_base_array,
+                                       size_t new_num_spots,
+                                       void *old_base_array,
+                                       size_t old_num_spots, size_t count) {
+    if (count > 0) {
+      std::memcpy(column_bytes_start_static<I>(new_base_array, new_num_spots),
+                  column_bytes_start_static<I>(old_base_array, old_num_spots),
+                  column_traits<NthType<I>>::bytes_for(count));
+    }
+  }
+
+  // sets elements [end, num_spots) of column I to the default value after the
+  // first end elements were copied in as bytes
+  template <size_t I>
+  static void fill_tail_static(void *base_array, size_t num_spots, size_t end,
+                               bool already_zero) {
+    if constexpr (EncodedColumn<NthType<I>>) {
+      // the bytes copied for the first end elements can hold parts of the
+      // elements after them
+      std::get<I>(column_pointers_static(base_array, num_spots))
+          .zero_from(end, num_spots);
+    } else if (!already_zero) {
+      NthType<I> *column =
+          get_starting_pointer_to_type_static<I>(base_array, num_spots);
+      std::fill(column + end, column + num_spots, NthType<I>());
+    }
+  }
+
+  // Encoded columns are kept zeroed past the rows that have been written,
+  // since their blocks are only consistent once every byte of them has been
+  // written. Plain columns are left alone.
+  template <std::size_t I>
+  static void zero_encoded_tail_static(void *base_array, size_t num_spots,
+                                       size_t count) {
+    if constexpr (EncodedColumn<NthType<I>>) {
+      std::get<I>(column_pointers_static(base_array, num_spots))
+          .zero_from(count, num_spots);
+    }
+  }
+
+  template <std::size_t... Is>
+  static void zero_encoded_tails_static(
+      void *base_array, size_t num_spots, size_t count,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    (zero_encoded_tail_static<Is>(base_array, num_spots, count), ...);
   }
 
   template <std::size_t... Is>
   static void *resize_impl_static(
       void *old_base_array, size_t old_num_spots, size_t new_num_spots,
-      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq,
+      size_t old_num_elements = std::numeric_limits<size_t>::max(),
+      Allocator allocator = Allocator()) {
 
     uintptr_t length_to_allocate = get_size_static(new_num_spots);
-    void *new_base_array = std::malloc(length_to_allocate);
+    size_t end = std::min({old_num_spots, old_num_elements, new_num_spots});
+
+    if constexpr (trivially_copyable) {
+      // zeroed allocations for large blocks come straight from fresh zero
+      // pages, so the tail never has to be written
+      bool zero_tail = default_is_zero();
+      void *new_base_array =
+          zero_tail
+              ? allocate_zeroed(allocator, length_to_allocate, base_alignment)
+              : allocator.allocate(length_to_allocate, base_alignment);
+      zero_padding_static(new_base_array, new_num_spots);
+      (copy_column_bytes_static<Is>(new_base_array, new_num_spots,
+                                    old_base_array, old_num_spots, end),
+       ...);
+      (fill_tail_static<Is>(new_base_array, new_num_spots, end, zero_tail),
+       ...);
+      return new_base_array;
+    } else {
+      void *new_base_array =
+          allocator.allocate(length_to_allocate, base_alignment);
+      zero_padding_static(new_base_array, new_num_spots);
+
+      const ColumnPointers new_columns =
+          column_pointers_static(new_base_array, new_num_spots);
+      const ColumnPointers old_columns =
+          column_pointers_static(old_base_array, old_num_spots);
+      for (size_t i = 0; i < end; i++) {
+        get_from_columns<Is...>(new_columns, i) =
+            get_from_columns<Is...>(old_columns, i);
+      }
+      const T zero;
+      for (size_t i = end; i < new_num_spots; i++) {
+        get_from_columns<Is...>(new_columns, i) = zero;
+      }
 
-    size_t end = std::min(old_num_spots, new_num_spots);
-    for (size_t i = 0; i < end; i++) {
-      get_static<Is...>(new_base_array, new_num_spots, i) =
-          get_static<Is...>(old_base_array, old_num_spots, i);
+      return new_base_array;
     }
-    const T zero;
-    for (size_t i = end; i < new_num_spots; i++) {
-      get_static<Is...>(new_base_array, new_num_spots, i) = zero;
+  }
+
+  // moves the first count elements of column I from its position in a layout
+  // of old_num_spots to its position in a layout of new_num_spots, both in the
+  // same allocation
+  template <size_t I>
+  static void move_column_in_place_static(void *base_array,
+                                          size_t old_num_spots,
+                                          size_t new_num_spots, size_t count) {
+    std::memmove(column_bytes_start_static<I>(base_array, new_num_spots),
+                 column_bytes_start_static<I>(base_array, old_num_spots),
+                 column_traits<NthType<I>>::bytes_for(count));
+  }
+
+  // grows or shrinks the allocation with the allocators reallocate, which it
+  // has said keeps the block without copying it, then slides each column to
+  // its new offset. When growing the columns only move towards the
+  // end so they are processed last to first, when shrinking they are
+  // processed first to last
+  template <std::size_t... Is>
+  static void *reallocate_in_place_static(
+      void *base_array, size_t old_num_spots, size_t new_num_spots,
+      size_t count, Allocator &allocator,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    static_assert(trivially_copyable && ReallocatingAllocator<Allocator>);
+    if (new_num_spots > old_num_spots) {
+      base_array = allocator.reallocate(
+          base_array, get_size_static(old_num_spots),
+          get_size_static(new_num_spots), base_alignment);
+      (move_column_in_place_static<num_types - 1 - Is>(
+           base_array, old_num_spots, new_num_spots, count),
+       ...);
+      zero_padding_static(base_array, new_num_spots);
+    } else {
+      (move_column_in_place_static<Is>(base_array, old_num_spots,
+                                       new_num_spots, count),
+       ...);
+      base_array = allocator.reallocate(
+          base_array, get_size_static(old_num_spots),
+          get_size_static(new_num_spots), base_alignment);
+      zero_padding_static(base_array, new_num_spots);
     }
+    return base_array;
+  }
 
-    return new_base_array;
+  // copies the first count elements of column I from the old layout into
+  // the new layout in one bulk copy, encoded columns are copied as bytes
+  template <std::size_t I>
+  static void relocate_column_static(void *new_base_array, size_t new_num_spots,
+                                     void *old_base_array, size_t old_num_spots,
+                                     size_t count) {
+    if constexpr (EncodedColumn<NthType<I>>) {
+      copy_column_bytes_static<I>(new_base_array, new_num_spots,
+                                  old_base_array, old_num_spots, count);
+    } else {
+      std::copy_n(
+          get_starting_pointer_to_type_static<I>(
+              static_cast<const void *>(old_base_array), old_num_spots),
+          count,
+          get_starting_pointer_to_type_static<I>(new_base_array,
+                                                 new_num_spots));
+    }
+  }
+
+  template <std::size_t... Is>
+  static void relocate_impl_static(
+      void *new_base_array, size_t new_num_spots, void *old_base_array,
+      size_t old_num_spots, size_t count,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    (relocate_column_static<Is>(new_base_array, new_num_spots, old_base_array,
+                                old_num_spots, count),
+     ...);
+  }
+
+  // copies column I of other after the elements of this one, element by
+  // element for encoded columns since other may not start on the same bit,
+  // and returns false if some block could not be encoded
+  template <size_t I> bool append_column(const BasicSOA &other) {
+    if constexpr (EncodedColumn<NthType<I>>) {
+      const auto &from = std::get<I>(other.column_starts);
+      return write_rows<I>(num_elements, num_elements + other.num_elements,
+                           [&](size_t i) { return from[i - num_elements]; });
+    } else {
+      std::copy_n(other.template get_starting_pointer_to_type<I>(),
+                  other.num_elements,
+                  get_starting_pointer_to_type<I>() + num_elements);
+      return true;
+    }
+  }
+
+  template <std::size_t... Is>
+  bool
+  append_impl(const BasicSOA &other,
+              [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    return (append_column<Is>(other) & ...);
+  }
+
+  // moves rows [from, from + count) of column I to start at row to, where the
+  // two ranges may overlap
+  template <size_t I>
+  void move_column_rows(size_t from, size_t to, size_t count) {
+    NthType<I> *column = std::get<I>(column_starts);
+    if constexpr (std::is_trivially_copyable_v<NthType<I>>) {
+      if (count > 0) {
+        std::memmove(column + to, column + from, count * sizeof(NthType<I>));
+      }
+    } else if (to > from) {
+      std::move_backward(column + from, column + from + count,
+                         column + to + count);
+    } else {
+      std::move(column + from, column + from + count, column + to);
+    }
   }
 
+  template <std::size_t... Is>
+  void move_rows(
+      size_t from, size_t to, size_t count,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    (move_column_rows<Is>(from, to, count), ...);
+  }
+
+  template <std::size_t... Is>
+  void insert_columns(
+      size_t pos, const BasicSOA &rows,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    (std::copy_n(std::get<Is>(rows.column_starts), rows.num_elements,
+                 std::get<Is>(column_starts) + pos),
+     ...);
+  }
+
+  // move to a new allocation with room for new_num_spots elements
+  void reallocate(size_t new_num_spots) {
+    if constexpr (trivially_copyable && ReallocatingAllocator<Allocator>) {
+      if (base_array != nullptr && new_num_spots > 0 &&
+          reallocates_in_place(allocator, base_alignment)) {
+        base_array = reallocate_in_place_static(
+            base_array, num_spots, new_num_spots, num_elements, allocator,
+            std::make_index_sequence<num_types>{});
+        zero_encoded_tails_static(base_array, new_num_spots, num_elements,
+                                  std::make_index_sequence<num_types>{});
+        num_spots = new_num_spots;
+        update_column_starts();
+        return;
+      }
+    }
+    void *new_base_array =
+        allocator.allocate(get_size_static(new_num_spots), base_alignment);
+    zero_padding_static(new_base_array, new_num_spots);
+    relocate_impl_static(new_base_array, new_num_spots, base_array, num_spots,
+                         num_elements, std::make_index_sequence<num_types>{});
+    zero_encoded_tails_static(new_base_array, new_num_spots, num_elements,
+                              std::make_index_sequence<num_types>{});
+    free_array();
+    base_array = new_base_array;
+    num_spots = new_num_spots;
+    update_column_starts();
+  }
+
+  // grow geometrically so that a sequence of appends is amortized O(1)
+  void grow_to_fit(size_t required_spots) {
+    if (required_spots > num_spots) {
+      reserve(std::max({required_spots, num_spots * 2, min_growth_spots}));
+    }
+  }
+
+  static constexpr size_t min_growth_spots = 16;
+
   template <size_t I>
-  static bool print_field_static(void *base_array, size_t num_spots) {
-    for (size_t i = 0; i < num_spots; i++) {
+  static bool print_field_static(void *base_array, size_t num_spots,
+                                 size_t end) {
+    for (size_t i = 0; i < end; i++) {
       std::cout << std::get<0>(get_static<I>(base_array, num_spots, i)) << ", ";
     }
     std::cout << "\n";
@@ -97,23 +577,17 @@ private:
   }
 
   template <size_t I> bool print_field() const {
-    return print_field_static<I>(base_array, num_spots);
+    return print_field_static<I>(base_array, num_spots, num_elements);
   }
 
   template <size_t... Is>
   static void print_soa_impl_static(
-      void *base_array, size_t num_spots,
+      void *base_array, size_t num_spots, size_t end,
       [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
-    auto x = {print_field_static<Is>(base_array, num_spots)...};
+    auto x = {print_field_static<Is>(base_array, num_spots, end)...};
     (void)x;
   }
 
-  template <size_t... Is>
-  void print_soa_impl(
-      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) const {
-    print_soa_impl_static<Is...>(base_array, num_spots, int_seq);
-  }
-
   template <size_t... Is>
   static auto get_impl_static(
       void *base_array, size_t num_spots, size_t i,
@@ -145,207 +619,1782 @@ private:
     return get_impl_static<Is...>(base_array, num_spots, i, int_seq);
   }
 
-public:
-  static constexpr size_t get_size_static(size_t num_spots) {
-    uintptr_t length_to_allocate = 0;
-    for (size_t i = 0; i < num_types; i++) {
-      length_to_allocate += num_spots * sizes[i];
-      if (i < num_types - 1) {
-        // get aligned for the next type
-        if (length_to_allocate % alignments[i + 1] != 0) {
-          length_to_allocate +=
-              alignments[i + 1] - (length_to_allocate % alignments[i + 1]);
-        }
-      }
+  // the columns an algorithm works on, all of them if none are given
+  template <size_t... Is> static constexpr auto selected_columns() {
+    if constexpr (sizeof...(Is) > 0) {
+      return std::integer_sequence<size_t, Is...>{};
+    } else {
+      return std::make_index_sequence<num_types>{};
     }
-    return length_to_allocate;
   }
-  [[nodiscard]] size_t get_size() const { return get_size_static(num_spots); }
-
-  [[nodiscard]] size_t size() const { return num_spots; }
 
-  SOA(size_t n) : num_spots(n) {
-    // set the total array to be 64 byte alignmed
-
-    uintptr_t length_to_allocate = get_size();
-    base_array = std::malloc(length_to_allocate);
+  // self is either a const or a non const BasicSOA, which picks the span type
+  template <class Self, size_t... Is>
+  static auto
+  columns_impl(Self &self,
+               [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    return std::make_tuple(self.template column<Is>()...);
   }
 
-  SOA(void *array, size_t n) : num_spots(n), base_array(array) {}
-
-  ~SOA() { free(base_array); }
+  template <bool Parallel, size_t... Selected, class R, class Map,
+            class Combine>
+  R reduce_impl(R identity, Map &&map, Combine &&combine, size_t start,
+                size_t end, size_t grain) const {
+    if constexpr (Parallel) {
+      return parallel_reduce<Selected...>(identity, map, combine, start, end,
+                                          grain);
+    } else {
+      return reduce<Selected...>(identity, map, combine, start, end);
+    }
+  }
 
-  static void zero_static(void *base_array, size_t num_spots) {
-    std::memset(base_array, 0, get_size_static(num_spots));
+  template <bool Parallel, size_t... Selected, size_t... Is>
+  auto sum_impl(size_t start, size_t end, size_t grain,
+                [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq)
+      const {
+    using R = std::common_type_t<sum_value_t<NthType<Is>>...>;
+    return reduce_impl<Parallel, Selected...>(
+        R(0), [](const auto &...args) { return (R(0) + ... + R(args)); },
+        std::plus<>(), start, end, grain);
   }
-  void zero() const { zero_static(base_array, num_spots); }
 
-  static NthType<0> get_element_static(const void *base_array, size_t num_spots,
-                                       size_t i) {
-    return get_starting_pointer_to_type_static<0>(base_array, num_spots)[i];
+  template <bool Parallel, bool Min, size_t... Selected, size_t... Is>
+  auto
+  min_max_impl(size_t start, size_t end, size_t grain,
+               [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq)
+      const {
+    using R = std::common_type_t<native_value_t<NthType<Is>>...>;
+    auto combine = [](R a, R b) {
+      if constexpr (Min) {
+        return std::min(a, b);
+      } else {
+        return std::max(a, b);
+      }
+    };
+    R identity = Min ? std::numeric_limits<R>::max()
+                     : std::numeric_limits<R>::lowest();
+    return reduce_impl<Parallel, Selected...>(
+        identity,
+        [&combine, identity](const auto &...args) {
+          R result = identity;
+          ((result = combine(result, R(args))), ...);
+          return result;
+        },
+        combine, start, end, grain);
   }
 
-  template <size_t... Is>
-  static auto get_static(void *base_array, size_t num_spots, size_t i) {
-    if constexpr (sizeof...(Is) > 0) {
-      return get_impl_static<Is...>(base_array, num_spots, i, {});
-    } else {
-      return get_impl_static(base_array, num_spots, i,
-                             std::make_index_sequence<num_types>{});
+  template <class Block, size_t... Is>
+  static void for_each_decoded_block_impl(
+      const ColumnPointers &columns, size_t start, size_t end, Block &&block,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    std::tuple<typename column_traits<NthType<Is>>::reader...> readers(
+        typename column_traits<NthType<Is>>::reader{std::get<Is>(columns)}...);
+    for (size_t lo = start; lo < end;) {
+      size_t hi =
+          std::min(lo - lo % encoded_block_size + encoded_block_size, end);
+      std::apply([&](auto &...reader) { (reader.load(lo, hi), ...); },
+                 readers);
+      block(readers, lo, hi);
+      lo = hi;
     }
   }
 
-  template <size_t... Is>
-  static auto get_static(const void *base_array, size_t num_spots, size_t i) {
-    if constexpr (sizeof...(Is) > 0) {
-      return get_impl_static<Is...>(base_array, num_spots, i, {});
+  // Calls block(readers, lo, hi) for consecutive blocks of rows that cover
+  // [start, end), where readers holds a column_traits reader for each of the
+  // selected columns with the rows [lo, hi) loaded, so reader[i] is the value
+  // of row i. The blocks end on multiples of encoded_block_size, so encoded
+  // columns are decoded a whole aligned block at a time.
+  template <size_t... Is, class Block>
+  static void for_each_decoded_block(const ColumnPointers &columns,
+                                     size_t start, size_t end, Block &&block) {
+    for_each_decoded_block_impl(columns, start, end, block,
+                                selected_columns<Is...>());
+  }
+
+  // the loops behind map_range and reduce, which work on column starts that
+  // are computed once rather than on the base array
+  template <size_t... Is, class F>
+  static void map_range_columns(const ColumnPointers &columns, F &&f,
+                                size_t start, size_t end) {
+    if constexpr (!read_by_block<F, void, Is...>()) {
+      for (size_t i = start; i < end; i++) {
+        std::apply(f, get_from_columns<Is...>(columns, i));
+      }
     } else {
-      return get_impl_static(base_array, num_spots, i,
-                             std::make_index_sequence<num_types>{});
+      for_each_decoded_block<Is...>(
+          columns, start, end,
+          [&](const auto &readers, size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+              std::apply([&](const auto &...reader) { f(reader[i]...); },
+                         readers);
+            }
+          });
     }
   }
 
-  template <size_t... Is>
-  static auto get_static_ptr(void *base_array, size_t num_spots, size_t i) {
-    if constexpr (sizeof...(Is) > 0) {
-      if constexpr (sizeof...(Is) == 1) {
-        return get_ptr_impl_static<Is...>(base_array, num_spots, i, {})
-            .get_pointer();
-      } else {
-        return get_ptr_impl_static<Is...>(base_array, num_spots, i, {});
+  template <size_t... Is, class F>
+  static void map_range_with_index_columns(const ColumnPointers &columns,
+                                           F &&f, size_t start, size_t end) {
+    if constexpr (!read_by_block<F, size_t, Is...>()) {
+      for (size_t i = start; i < end; i++) {
+        std::apply(f, std::tuple_cat(std::make_tuple(i),
+                                     get_from_columns<Is...>(columns, i)));
       }
     } else {
-      return get_ptr_impl_static(base_array, num_spots, i,
-                                 std::make_index_sequence<num_types>{});
+      for_each_decoded_block<Is...>(
+          columns, start, end,
+          [&](const auto &readers, size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; i++) {
+              std::apply([&](const auto &...reader) { f(i, reader[i]...); },
+                         readers);
+            }
+          });
     }
   }
 
-  template <size_t... Is> auto get(size_t i) const {
-    return get_static<Is...>(base_array, num_spots, i);
+  template <size_t... Is, class F>
+  static void parallel_map_range_columns(const ColumnPointers &columns, F &&f,
+                                         size_t start, size_t end,
+                                         size_t grain) {
+    parallel_for_chunks(start, end, parallel_grain<Is...>(grain),
+                        [&](size_t lo, size_t hi) {
+                          map_range_columns<Is...>(columns, f, lo, hi);
+                        });
   }
 
-  template <size_t... Is> auto get_ptr(size_t i) const {
-    return get_static_ptr<Is...>(base_array, num_spots, i);
+  template <size_t... Is, class F>
+  static void parallel_map_range_with_index_columns(
+      const ColumnPointers &columns, F &&f, size_t start, size_t end,
+      size_t grain) {
+    parallel_for_chunks(start, end, parallel_grain<Is...>(grain),
+                        [&](size_t lo, size_t hi) {
+                          map_range_with_index_columns<Is...>(columns, f, lo,
+                                                              hi);
+                        });
   }
 
-  static void print_type_details() {
-    std::cout << "num types are " << num_types << "\n";
-    std::cout << "their alignments are ";
-    for (const auto e : alignments) {
-      std::cout << e << ", ";
+  template <size_t FlagCol, size_t... Is, class F>
+  static void map_range_where_columns(const ColumnPointers &columns, F &&f,
+                                      size_t start, size_t end) {
+    const auto &flags = std::get<FlagCol>(columns);
+    auto visit = [&](size_t i) {
+      std::apply(f, get_from_columns<Is...>(columns, i));
+    };
+    if constexpr (BitColumn<column_pointer_t<NthType<FlagCol>>>) {
+      flags.for_each_set(start, end, visit);
+    } else {
+      for (size_t i = start; i < end; i++) {
+        if (flags[i]) {
+          visit(i);
+        }
+      }
     }
-    std::cout << "\n";
-    std::cout << "their sizes are ";
-    for (const auto e : sizes) {
-      std::cout << e << ", ";
+  }
+
+  template <size_t W, size_t... Is, class F>
+  static void map_range_simd_columns(
+      const ColumnPointers &columns, F &&f, size_t start, size_t end,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    static_assert(plain_columns<Is...>(),
+                  "map_range_simd loads straight from the columns");
+    if constexpr ((column_traits<NthType<Is>>::read_in_place && ...)) {
+      size_t i = start;
+      for (; i + W <= end; i += W) {
+        f(simd_batch<native_value_t<NthType<Is>>, W>::load(
+            std::get<Is>(columns) + i)...);
+      }
+      if (i < end) {
+        f(simd_batch<native_value_t<NthType<Is>>, W>::load(
+            std::get<Is>(columns) + i, end - i)...);
+      }
+    } else {
+      // columns with a codec are decoded encoded_block_size rows at a time,
+      // which is a whole number of batches, so only the last batch is partial
+      static_assert(encoded_block_size % W == 0);
+      std::tuple<typename column_traits<NthType<Is>>::reader...> readers(
+          typename column_traits<NthType<Is>>::reader{
+              std::get<Is>(columns)}...);
+      for (size_t lo = start; lo < end; lo += encoded_block_size) {
+        size_t hi = std::min(lo + encoded_block_size, end);
+        std::apply(
+            [&](auto &...reader) {
+              (reader.load(lo, hi), ...);
+              size_t i = lo;
+              for (; i + W <= hi; i += W) {
+                f(simd_batch<native_value_t<NthType<Is>>, W>::load(
+                    &reader[i])...);
+              }
+              if (i < hi) {
+                f(simd_batch<native_value_t<NthType<Is>>, W>::load(
+                    &reader[i], hi - i)...);
+              }
+            },
+            readers);
+      }
     }
-    std::cout << "\n";
   }
 
-  template <size_t... Is>
-  static void print_soa_static(void *base_array, size_t num_spots) {
-    if constexpr (sizeof...(Is) > 0) {
-      print_soa_impl_static<Is...>(base_array, num_spots, {});
+  template <size_t... Is, class R, class Map, class Combine>
+  static R reduce_columns(const ColumnPointers &columns, R identity, Map &&map,
+                          Combine &&combine, size_t start, size_t end) {
+    if constexpr (!read_by_block<Map, void, Is...>()) {
+      return reduce_range(
+          start, end, identity,
+          [&](size_t i) -> R {
+            return std::apply(map, get_from_columns<Is...>(columns, i));
+          },
+          combine);
     } else {
-      print_soa_impl_static(base_array, num_spots,
-                            std::make_index_sequence<num_types>{});
+      R result = identity;
+      for_each_decoded_block<Is...>(
+          columns, start, end,
+          [&](const auto &readers, size_t lo, size_t hi) {
+            result = combine(
+                result, reduce_range(
+                            lo, hi, identity,
+                            [&](size_t i) -> R {
+                              return std::apply(
+                                  [&](const auto &...reader) {
+                                    return map(reader[i]...);
+                                  },
+                                  readers);
+                            },
+                            combine));
+          });
+      return result;
     }
   }
-  template <size_t... Is> void print_soa() const {
-    print_soa_static<Is...>(base_array, num_spots);
+
+  template <size_t... Is, class R, class Map, class Combine>
+  static R parallel_reduce_columns(const ColumnPointers &columns, R identity,
+                                   Map &&map, Combine &&combine, size_t start,
+                                   size_t end, size_t grain) {
+    return parallel_reduce_chunks(
+        start, end, parallel_grain<Is...>(grain), identity,
+        [&](size_t lo, size_t hi) {
+          return reduce_columns<Is...>(columns, identity, map, combine, lo, hi);
+        },
+        combine);
   }
 
-  template <size_t... Is, class F>
-  static void
-  map_range_static(void *base_array, size_t num_spots, F &&f, size_t start = 0,
-                   size_t end = std::numeric_limits<size_t>::max()) {
-    if (end == std::numeric_limits<size_t>::max()) {
-      end = num_spots;
-    }
-    for (size_t i = start; i < end; i++) {
-      std::apply(f, get_static<Is...>(base_array, num_spots, i));
+  // a key from column K together with the row it came from, the index is 32
+  // bits when that is enough so that more keys fit in each cache line
+  template <size_t K, class Index>
+  using KeyedRow = std::pair<sort_key_t<NthType<K>>, Index>;
+
+  // writes column I of the rows in the order given by keyed into new_columns,
+  // the key column comes straight from keyed and every other column is one
+  // gather pass through the old column
+  template <size_t I, size_t K, bool Parallel, class Index>
+  void gather_column(const ColumnPointers &new_columns,
+                     const std::vector<KeyedRow<K, Index>> &keyed,
+                     size_t grain) {
+    NthType<I> *dest = std::get<I>(new_columns);
+    const NthType<I> *src = std::get<I>(column_starts);
+    auto gather = [&](size_t lo, size_t hi) {
+      for (size_t i = lo; i < hi; i++) {
+        if constexpr (I == K) {
+          dest[i] = keyed[i].first;
+        } else {
+          dest[i] = src[keyed[i].second];
+        }
+      }
+    };
+    if constexpr (Parallel) {
+      parallel_for_chunks(0, num_elements, parallel_grain<I>(grain), gather);
+    } else {
+      gather(0, num_elements);
     }
   }
 
-  template <size_t... Is, class F>
-  void map_range(F &&f, size_t start = 0,
-                 size_t end = std::numeric_limits<size_t>::max()) const {
-    map_range_static<Is...>(base_array, num_spots, f, start, end);
+  // replaces the array with a new one of the same capacity, whose columns are
+  // written by fill(new_columns)
+  template <class Fill> void rebuild_array(Fill &&fill) {
+    void *new_base_array = allocator.allocate(get_size(), base_alignment);
+    zero_padding_static(new_base_array, num_spots);
+    fill(column_pointers_static(new_base_array, num_spots));
+    free_array();
+    base_array = new_base_array;
+    update_column_starts();
   }
 
-  template <size_t... Is, class F>
-  static void
-  map_range_with_index_static(void *base_array, size_t num_spots, F &&f,
-                              size_t start = 0,
-                              size_t end = std::numeric_limits<size_t>::max()) {
+  template <size_t K, bool Parallel, class Index, size_t... Is>
+  void gather_rows(
+      const std::vector<KeyedRow<K, Index>> &keyed, size_t grain,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    rebuild_array([&](const ColumnPointers &new_columns) {
+      (gather_column<Is, K, Parallel, Index>(new_columns, keyed, grain), ...);
+    });
+  }
+
+  // pairs every key of column K with its row, hands the pairs to sort_keys to
+  // be put in order, and then gathers the rows into that order
+  template <size_t K, bool Parallel, class Index, class SortKeys>
+  void sort_keyed_rows(SortKeys &&sort_keys, size_t grain) {
+    std::vector<KeyedRow<K, Index>> keyed(num_elements);
+    const NthType<K> *keys = std::get<K>(column_starts);
+    auto fill = [&](size_t lo, size_t hi) {
+      for (size_t i = lo; i < hi; i++) {
+        keyed[i] = {keys[i], static_cast<Index>(i)};
+      }
+    };
+    if constexpr (Parallel) {
+      parallel_for_chunks(0, num_elements, grain, fill);
+    } else {
+      fill(0, num_elements);
+    }
+    sort_keys(keyed);
+    gather_rows<K, Parallel>(keyed, grain,
+                             std::make_index_sequence<num_types>{});
+  }
+
+  // Sorts the rows by column K. Only the keys are sorted, each paired with the
+  // row it came from, and then each column is moved to its new order in a
+  // single pass, rather than swapping whole rows through the iterator.
+  // sort_keys is called with a vector of KeyedRow and must sort it by key.
+  template <size_t K, bool Parallel, class SortKeys>
+  void sort_by_impl(SortKeys &&sort_keys, size_t grain) {
+    static_assert(plain_columns(),
+                  "sorting moves the elements of every column");
+    if (num_elements <= 1) {
+      return;
+    }
+    if (num_elements <= std::numeric_limits<uint32_t>::max()) {
+      sort_keyed_rows<K, Parallel, uint32_t>(sort_keys, grain);
+    } else {
+      sort_keyed_rows<K, Parallel, uint64_t>(sort_keys, grain);
+    }
+  }
+
+  template <size_t K, bool Stable, bool Parallel, class Compare>
+  void comparison_sort_by(Compare comp, size_t grain) {
+    auto by_key = [&comp](const auto &a, const auto &b) {
+      return comp(a.first, b.first);
+    };
+    sort_by_impl<K, Parallel>(
+        [&](auto &keyed) {
+          if constexpr (Parallel) {
+            parallel_sort<Stable>(keyed.begin(), keyed.end(), by_key, grain);
+          } else if constexpr (Stable) {
+            std::stable_sort(keyed.begin(), keyed.end(), by_key);
+          } else {
+            std::sort(keyed.begin(), keyed.end(), by_key);
+          }
+        },
+        grain);
+  }
+
+  // only the bytes that are stored in the column need a pass, so a
+  // sized_uint<5> key takes 5 passes even though it is read as a uint64_t
+  template <size_t K, bool Parallel> void radix_sort_by_impl(size_t grain) {
+    using Key = sort_key_t<NthType<K>>;
+    static_assert(std::is_integral_v<Key> && !std::is_same_v<Key, bool>,
+                  "radix sort needs an integer key column");
+    sort_by_impl<K, Parallel>(
+        [&](auto &keyed) {
+          radix_sort<sizeof(NthType<K>), Parallel>(
+              keyed, [](const auto &e) { return radix_key(e.first); }, grain);
+        },
+        grain);
+  }
+
+  // calls f(lo, hi) over [0, num_elements) in blocks of grain rows, in
+  // parallel with Parallel and as a single block otherwise, and not at all
+  // for an empty table, which has no block
+  template <bool Parallel, class F>
+  void for_each_block(size_t grain, F &&f) const {
+    if constexpr (Parallel) {
+      parallel_for_chunks(0, num_elements, grain, f);
+    } else if (num_elements > 0) {
+      f(0, num_elements);
+    }
+  }
+
+  // The rows a predicate selected. keep has a byte per row that is 1 if the
+  // row was selected, and offsets[b] is the number of selected rows before
+  // block b of grain rows, with the total at the end.
+  struct Selection {
+    std::vector<uint8_t> keep;
+    std::vector<size_t> offsets;
+    size_t grain;
+
+    [[nodiscard]] size_t count() const { return offsets.back(); }
+  };
+
+  // evaluates pred over only the selected columns of every row, counting the
+  // selected rows of each block, and then takes a prefix sum of the counts
+  template <bool Parallel, size_t... Is, class F>
+  Selection select_rows(F &&pred, size_t grain) const {
+    Selection selection;
+    selection.grain = Parallel ? parallel_grain(grain)
+                               : std::max(num_elements, size_t(1));
+    selection.keep.resize(num_elements);
+    selection.offsets.assign(
+        (num_elements + selection.grain - 1) / selection.grain + 1, 0);
+    for_each_block<Parallel>(selection.grain, [&](size_t lo, size_t hi) {
+      size_t count = 0;
+      for (size_t i = lo; i < hi; i++) {
+        uint8_t keep =
+            std::apply(pred, get_from_columns<Is...>(column_starts, i)) ? 1
+                                                                        : 0;
+        selection.keep[i] = keep;
+        count += keep;
+      }
+      selection.offsets[lo / selection.grain + 1] = count;
+    });
+    for (size_t b = 1; b < selection.offsets.size(); b++) {
+      selection.offsets[b] += selection.offsets[b - 1];
+    }
+    return selection;
+  }
+
+  // writes the selected rows of column I, in order, starting at dest
+  template <size_t I, bool Parallel>
+  void compress_column(const Selection &selection, NthType<I> *dest) const {
+    const NthType<I> *src = std::get<I>(column_starts);
+    for_each_block<Parallel>(selection.grain, [&](size_t lo, size_t hi) {
+      compress_store(src + lo, selection.keep.data() + lo, hi - lo,
+                     dest + selection.offsets[lo / selection.grain]);
+    });
+  }
+
+  // writes the selected rows of column I followed by the rest, each in order,
+  // starting at dest
+  template <size_t I, bool Parallel>
+  void partition_column(const Selection &selection, NthType<I> *dest) const {
+    const NthType<I> *src = std::get<I>(column_starts);
+    for_each_block<Parallel>(selection.grain, [&](size_t lo, size_t hi) {
+      size_t kept_before = selection.offsets[lo / selection.grain];
+      partition_store(src + lo, selection.keep.data() + lo, hi - lo,
+                      dest + kept_before,
+                      dest + selection.count() + (lo - kept_before));
+    });
+  }
+
+  // keeps only the selected rows. Serially each column is compacted in place,
+  // in parallel the blocks would overwrite rows other blocks have not read
+  // yet, so the columns are compacted into a new array.
+  template <bool Parallel, size_t... Is>
+  void keep_rows(
+      const Selection &selection,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    if constexpr (Parallel) {
+      rebuild_array([&](const ColumnPointers &new_columns) {
+        (compress_column<Is, true>(selection, std::get<Is>(new_columns)), ...);
+      });
+    } else {
+      (compress_column<Is, false>(selection, std::get<Is>(column_starts)), ...);
+    }
+    num_elements = selection.count();
+  }
+
+  template <bool Parallel, size_t... Is>
+  void partition_rows(
+      const Selection &selection,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) {
+    rebuild_array([&](const ColumnPointers &new_columns) {
+      (partition_column<Is, Parallel>(selection, std::get<Is>(new_columns)),
+       ...);
+    });
+  }
+
+  template <bool Parallel, size_t... Is>
+  void append_rows(
+      const Selection &selection, BasicSOA &dest,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) const {
+    dest.grow_to_fit(dest.num_elements + selection.count());
+    (compress_column<Is, Parallel>(
+         selection, std::get<Is>(dest.column_starts) + dest.num_elements),
+     ...);
+    dest.num_elements += selection.count();
+  }
+
+  // true if the selection is a single dictionary encoded column
+  template <size_t... Is> static constexpr bool dictionary_column() {
+    if constexpr (sizeof...(Is) == 1) {
+      return (DictionaryColumn<column_pointer_t<NthType<Is>>> && ...);
+    } else {
+      return false;
+    }
+  }
+
+  // count_if on a dictionary column, which tests pred against each value of
+  // the dictionary once and then counts the rows with a matching code
+  template <bool Parallel, size_t I, class F>
+  size_t count_matching_codes(F &&pred, size_t start, size_t end,
+                              size_t grain) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    const auto &column = std::get<I>(column_starts);
+    auto match = column.match(pred);
+    auto count_chunk = [&](size_t lo, size_t hi) {
+      return column.count_matching(match, lo, hi);
+    };
+    if constexpr (Parallel) {
+      return parallel_reduce_chunks(start, end, parallel_grain<I>(grain),
+                                    size_t(0), count_chunk, std::plus<>());
+    } else {
+      return count_chunk(start, end);
+    }
+  }
+
+  template <bool Parallel, size_t... Is, class F>
+  size_t erase_if_impl(F &&pred, size_t grain) {
+    static_assert(plain_columns(), "rows are compacted a column at a time");
+    size_t old_num_elements = num_elements;
+    keep_rows<Parallel>(
+        select_rows<Parallel, Is...>(
+            [&pred](const auto &...args) -> bool { return !pred(args...); },
+            grain),
+        std::make_index_sequence<num_types>{});
+    return old_num_elements - num_elements;
+  }
+
+  template <bool Parallel, size_t... Is, class F>
+  size_t partition_impl(F &&pred, size_t grain) {
+    static_assert(plain_columns(), "rows are compacted a column at a time");
+    Selection selection = select_rows<Parallel, Is...>(pred, grain);
+    partition_rows<Parallel>(selection, std::make_index_sequence<num_types>{});
+    return selection.count();
+  }
+
+  template <bool Parallel, size_t... Is, class F>
+  size_t filter_into_impl(BasicSOA &dest, F &&pred, size_t grain) const {
+    static_assert(plain_columns(), "rows are compacted a column at a time");
+    Selection selection = select_rows<Parallel, Is...>(pred, grain);
+    append_rows<Parallel>(selection, dest,
+                          std::make_index_sequence<num_types>{});
+    return selection.count();
+  }
+
+  template <bool ReadOnly, size_t... Is>
+  BasicSOAView<ReadOnly, NthType<Is>...>
+  view_impl(size_t start, size_t end,
+            [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq)
+      const {
+    using View = BasicSOAView<ReadOnly, NthType<Is>...>;
+    return View(typename View::ColumnPointers(std::get<Is>(column_starts)...),
+                start, end - start);
+  }
+
+  // the BasicSOA holding just the selected columns, all of them if none are
+  // given
+  template <size_t... Is>
+  static auto projection_type(
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq)
+      -> BasicSOA<Layout, Allocator, NthType<Is>...>;
+
+  // Copies the selected columns of row indices[j] to out[j] for every j, where
+  // out holds one pointer per selected column. Every selected column of each
+  // row is prefetched prefetch_distance lookups ahead, so there are many
+  // misses in flight at once instead of one row at a time.
+  template <class R, class Out, size_t... Is, size_t... Js>
+  void gather_impl(
+      const R &indices, const Out &out,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> columns,
+      [[maybe_unused]] std::integer_sequence<size_t, Js...> positions) const {
+    static_assert(plain_columns<Is...>(),
+                  "gather prefetches element addresses");
+    for_each_prefetched(
+        std::ranges::size(indices),
+        [&](size_t j) {
+          (prefetch<false>(std::get<Is>(column_starts) + indices[j]), ...);
+        },
+        [&](size_t j) {
+          size_t i = indices[j];
+          ((std::get<Js>(out)[j] = std::get<Is>(column_starts)[i]), ...);
+        });
+  }
+
+  template <class R, class Values, size_t... Is, size_t... Js>
+  void scatter_impl(
+      const R &indices, const Values &values,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> columns,
+      [[maybe_unused]] std::integer_sequence<size_t, Js...> positions) {
+    static_assert(plain_columns<Is...>(),
+                  "scatter prefetches element addresses");
+    for_each_prefetched(
+        std::ranges::size(indices),
+        [&](size_t j) {
+          (prefetch<true>(std::get<Is>(column_starts) + indices[j]), ...);
+        },
+        [&](size_t j) {
+          size_t i = indices[j];
+          ((std::get<Is>(column_starts)[i] = std::get<Js>(values)[j]), ...);
+        });
+  }
+
+  // Writes value_at(i) to row i of column I for every i in [start, end).
+  // Columns with a codec, and encoded columns written in bulk, are given the
+  // values a block at a time to encode. Returns false if some block could not
+  // be encoded.
+  template <size_t I, class Value>
+  bool write_rows(size_t start, size_t end, Value &&value_at) {
+    using Traits = column_traits<NthType<I>>;
+    auto column = std::get<I>(column_starts);
+    if constexpr (CodecColumn<NthType<I>> ||
+                  BulkEncodedColumn<typename Traits::pointer>) {
+      std::array<typename Traits::value_type, encoded_block_size> block;
+      bool encoded = true;
+      for (size_t lo = start; lo < end;) {
+        size_t hi =
+            std::min(lo - lo % encoded_block_size + encoded_block_size, end);
+        for (size_t i = lo; i < hi; i++) {
+          block[i - lo] = static_cast<typename Traits::value_type>(value_at(i));
+        }
+        if constexpr (CodecColumn<NthType<I>>) {
+          Traits::codec::encode(block.data(), lo, hi, column);
+        } else {
+          encoded &= column.encode(block.data(), lo, hi);
+        }
+        lo = hi;
+      }
+      return encoded;
+    } else {
+      for (size_t i = start; i < end; i++) {
+        column[i] = value_at(i);
+      }
+      return true;
+    }
+  }
+
+public:
+  static constexpr size_t get_size_static(size_t num_spots) {
+    // the total length is padded out so it can be passed to aligned_alloc
+    return round_up(column_offset_static(num_types - 1, num_spots) +
+                        column_bytes(num_types - 1, num_spots) +
+                        Layout::tail_padding,
+                    base_alignment);
+  }
+  [[nodiscard]] size_t get_size() const { return get_size_static(num_spots); }
+
+  [[nodiscard]] size_t size() const { return num_elements; }
+
+  [[nodiscard]] size_t capacity() const { return num_spots; }
+
+  [[nodiscard]] bool empty() const { return num_elements == 0; }
+
+  BasicSOA(Allocator alloc = Allocator())
+      : num_spots(0), num_elements(0), base_array(nullptr), column_starts(),
+        allocator(alloc) {}
+
+  BasicSOA(size_t n, Allocator alloc = Allocator())
+      : num_spots(n), num_elements(n), base_array(nullptr), allocator(alloc) {
+    // the array and each column are aligned as described by Layout
+    uintptr_t length_to_allocate = get_size();
+    base_array = allocator.allocate(length_to_allocate, base_alignment);
+    zero_padding_static(base_array, num_spots);
+    zero_encoded_tails_static(base_array, num_spots, 0,
+                              std::make_index_sequence<num_types>{});
+    update_column_starts();
+  }
+
+  // takes ownership of array, which must have come from alloc
+  BasicSOA(void *array, size_t n, Allocator alloc = Allocator())
+      : num_spots(n), num_elements(n), base_array(array),
+        column_starts(column_pointers_static(array, n)), allocator(alloc) {}
+
+  // takes ownership of array, which must have come from alloc and be laid out
+  // for capacity spots of which the first n are in use
+  BasicSOA(void *array, size_t capacity, size_t n,
+           Allocator alloc = Allocator())
+      : num_spots(capacity), num_elements(n), base_array(array),
+        column_starts(column_pointers_static(array, capacity)),
+        allocator(alloc) {}
+
+  // A BasicSOA owns its block, so it can only be moved, which hands the block
+  // over in O(1) and leaves other empty. Use clone for a copy.
+  BasicSOA(const BasicSOA &other) = delete;
+  BasicSOA &operator=(const BasicSOA &other) = delete;
+
+  BasicSOA(BasicSOA &&other) noexcept
+      : num_spots(std::exchange(other.num_spots, 0)),
+        num_elements(std::exchange(other.num_elements, 0)),
+        base_array(std::exchange(other.base_array, nullptr)),
+        column_starts(std::exchange(other.column_starts, ColumnPointers())),
+        allocator(other.allocator) {}
+
+  BasicSOA &operator=(BasicSOA &&other) noexcept {
+    if (this != &other) {
+      free_array();
+      num_spots = std::exchange(other.num_spots, 0);
+      num_elements = std::exchange(other.num_elements, 0);
+      base_array = std::exchange(other.base_array, nullptr);
+      column_starts = std::exchange(other.column_starts, ColumnPointers());
+      allocator = other.allocator;
+    }
+    return *this;
+  }
+
+  ~BasicSOA() { free_array(); }
+
+  void swap(BasicSOA &other) noexcept {
+    std::swap(num_spots, other.num_spots);
+    std::swap(num_elements, other.num_elements);
+    std::swap(base_array, other.base_array);
+    std::swap(column_starts, other.column_starts);
+    std::swap(allocator, other.allocator);
+  }
+
+  friend void swap(BasicSOA &a, BasicSOA &b) noexcept { a.swap(b); }
+
+  // A copy with the same size and capacity in a new block from the same
+  // allocator. Each column is copied in bulk, as resize does.
+  BasicSOA clone() const {
+    if (base_array == nullptr) {
+      return BasicSOA(allocator);
+    }
+    return BasicSOA(resize_impl_static(base_array, num_spots, num_spots,
+                                       std::make_index_sequence<num_types>{},
+                                       num_elements, allocator),
+                    num_spots, num_elements, allocator);
+  }
+
+  // Gives up the block without freeing it and leaves the container empty.
+  // The block is laid out for capacity() spots of which size() are in use, so
+  // read those first to adopt it again or to free it with the allocator.
+  [[nodiscard]] void *release() {
+    num_spots = 0;
+    num_elements = 0;
+    column_starts = ColumnPointers();
+    return std::exchange(base_array, nullptr);
+  }
+
+  // frees the current block and takes ownership of array, which must have
+  // come from the allocator of this container and be laid out for capacity
+  // spots of which the first n are in use
+  void adopt(void *array, size_t capacity, size_t n) {
+    free_array();
+    base_array = array;
+    num_spots = capacity;
+    num_elements = n;
+    if (array == nullptr) {
+      column_starts = ColumnPointers();
+    } else {
+      update_column_starts();
+    }
+  }
+
+  [[nodiscard]] Allocator get_allocator() const { return allocator; }
+
+  static void zero_static(void *base_array, size_t num_spots) {
+    std::memset(base_array, 0, get_size_static(num_spots));
+  }
+  void zero() const { zero_static(base_array, num_spots); }
+
+  static NthType<0> get_element_static(const void *base_array, size_t num_spots,
+                                       size_t i) {
+    return get_starting_pointer_to_type_static<0>(base_array, num_spots)[i];
+  }
+
+  template <size_t... Is>
+  static auto get_static(void *base_array, size_t num_spots, size_t i) {
+    if constexpr (sizeof...(Is) > 0) {
+      return get_impl_static<Is...>(base_array, num_spots, i, {});
+    } else {
+      return get_impl_static(base_array, num_spots, i,
+                             std::make_index_sequence<num_types>{});
+    }
+  }
+
+  template <size_t... Is>
+  static auto get_static(const void *base_array, size_t num_spots, size_t i) {
+    if constexpr (sizeof...(Is) > 0) {
+      return get_impl_static<Is...>(base_array, num_spots, i, {});
+    } else {
+      return get_impl_static(base_array, num_spots, i,
+                             std::make_index_sequence<num_types>{});
+    }
+  }
+
+  template <size_t... Is>
+  static auto get_static_ptr(void *base_array, size_t num_spots, size_t i) {
+    if constexpr (sizeof...(Is) > 0) {
+      if constexpr (sizeof...(Is) == 1) {
+        return get_ptr_impl_static<Is...>(base_array, num_spots, i, {})
+            .get_pointer();
+      } else {
+        return get_ptr_impl_static<Is...>(base_array, num_spots, i, {});
+      }
+    } else {
+      return get_ptr_impl_static(base_array, num_spots, i,
+                                 std::make_index_sequence<num_types>{});
+    }
+  }
+
+  template <size_t... Is> auto get(size_t i) const {
+    return get_from_columns<Is...>(column_starts, i);
+  }
+
+  template <size_t... Is> auto get_ptr(size_t i) const {
+    return get_ptr_from_columns<Is...>(column_starts, i);
+  }
+
+  // the type of a BasicSOA with just the selected columns, as returned by
+  // pull_types
+  template <size_t... Is>
+  using Projection = decltype(projection_type(selected_columns<Is...>()));
+
+  // Replaces the contents of out with the selected columns of the rows at
+  // indices, in the order of indices.
+  template <size_t... Is, class R>
+  void gather(const R &indices, Projection<Is...> &out) const {
+    size_t n = std::ranges::size(indices);
+    out.clear();
+    out.reserve(n);
+    out.num_elements = n;
+    gather_impl(indices, out.column_starts, selected_columns<Is...>(),
+                std::make_index_sequence<Projection<Is...>::num_types>{});
+  }
+
+  // writes the selected columns of the rows at indices to the arrays out, one
+  // for each selected column and each with room for every index
+  template <size_t... Is, class R>
+  void gather(const R &indices, NthType<Is> *...out) const {
+    static_assert(sizeof...(Is) > 0);
+    gather_impl(indices, std::make_tuple(out...), selected_columns<Is...>(),
+                std::make_index_sequence<sizeof...(Is)>{});
+  }
+
+  // Writes row j of values to the row at indices[j], for the selected
+  // columns. If an index is repeated the last of its rows is the one kept.
+  template <size_t... Is, class R>
+  void scatter(const R &indices, const Projection<Is...> &values) {
+    scatter_impl(indices, values.column_starts, selected_columns<Is...>(),
+                 std::make_index_sequence<Projection<Is...>::num_types>{});
+  }
+
+  template <size_t... Is, class R>
+  void scatter(const R &indices, const NthType<Is> *...values) {
+    static_assert(sizeof...(Is) > 0);
+    scatter_impl(indices, std::make_tuple(values...), selected_columns<Is...>(),
+                 std::make_index_sequence<sizeof...(Is)>{});
+  }
+
+  // Writes values[0, end - start) to rows [start, end) of column I, converting
+  // each to the type of the column. Columns with a codec, such as the
+  // sized_uint widths that are not a native type, are encoded straight from
+  // values when they already are the type the codec reads as. Returns false
+  // if the column could not represent some of the values, which only encoded
+  // columns with a limited range such as frame_uint do, and the blocks they
+  // fall in are left as they were.
+  template <size_t I, class U>
+  bool assign(const U *values, size_t start = 0,
+              size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    using Traits = column_traits<NthType<I>>;
+    if constexpr (CodecColumn<NthType<I>> &&
+                  std::is_same_v<U, typename Traits::value_type>) {
+      Traits::codec::encode(values, start, end, std::get<I>(column_starts));
+      return true;
+    } else {
+      return write_rows<I>(start, end,
+                           [&](size_t i) { return values[i - start]; });
+    }
+  }
+
+  // sets rows [start, end) of column I to value, with the same result as
+  // assign
+  template <size_t I, class U>
+  bool fill(const U &value, size_t start = 0,
+            size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return write_rows<I>(start, end,
+                         [&]([[maybe_unused]] size_t i) { return value; });
+  }
+
+  // the first end elements of column I as one contiguous span, which can be
+  // handed to std algorithms or any other code that takes a plain array
+  template <size_t I>
+  static std::span<NthType<I>>
+  column_static(void *base_array, size_t num_spots,
+                size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    return {get_starting_pointer_to_type_static<I>(base_array, num_spots), end};
+  }
+
+  template <size_t I>
+  static std::span<const NthType<I>>
+  column_static(const void *base_array, size_t num_spots,
+                size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    return {get_starting_pointer_to_type_static<I>(base_array, num_spots), end};
+  }
+
+  template <size_t I> std::span<NthType<I>> column() {
+    static_assert(plain_columns<I>(), "encoded columns are not arrays");
+    return {std::get<I>(column_starts), num_elements};
+  }
+
+  template <size_t I> std::span<const NthType<I>> column() const {
+    static_assert(plain_columns<I>(), "encoded columns are not arrays");
+    return {std::get<I>(column_starts), num_elements};
+  }
+
+  // a tuple with the span of each of the selected columns, all of them if
+  // none are given
+  template <size_t... Is> auto columns() {
+    return columns_impl(*this, selected_columns<Is...>());
+  }
+
+  template <size_t... Is> auto columns() const {
+    return columns_impl(*this, selected_columns<Is...>());
+  }
+
+  static void print_type_details() {
+    std::cout << "num types are " << num_types << "\n";
+    std::cout << "their alignments are ";
+    for (const auto e : alignments) {
+      std::cout << e << ", ";
+    }
+    std::cout << "\n";
+    std::cout << "their sizes are ";
+    for (const auto e : sizes) {
+      std::cout << e << ", ";
+    }
+    std::cout << "\n";
+  }
+
+  template <size_t... Is>
+  static void
+  print_soa_static(void *base_array, size_t num_spots,
+                   size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    if constexpr (sizeof...(Is) > 0) {
+      print_soa_impl_static<Is...>(base_array, num_spots, end, {});
+    } else {
+      print_soa_impl_static(base_array, num_spots, end,
+                            std::make_index_sequence<num_types>{});
+    }
+  }
+  template <size_t... Is> void print_soa() const {
+    print_soa_static<Is...>(base_array, num_spots, num_elements);
+  }
+
+  template <size_t... Is, class F>
+  static void
+  map_range_static(void *base_array, size_t num_spots, F &&f, size_t start = 0,
+                   size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    map_range_columns<Is...>(column_pointers_static(base_array, num_spots), f,
+                             start, end);
+  }
+
+  template <size_t... Is, class F>
+  void map_range(F &&f, size_t start = 0,
+                 size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    map_range_columns<Is...>(column_starts, f, start, end);
+  }
+
+  template <size_t... Is, class F>
+  static void
+  map_range_with_index_static(void *base_array, size_t num_spots, F &&f,
+                              size_t start = 0,
+                              size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    map_range_with_index_columns<Is...>(
+        column_pointers_static(base_array, num_spots), f, start, end);
+  }
+
+  template <size_t... Is, class F>
+  void
+  map_range_with_index(F &&f, size_t start = 0,
+                       size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    map_range_with_index_columns<Is...>(column_starts, f, start, end);
+  }
+
+  // number of elements that is a whole number of cache lines in every one of
+  // the selected columns
+  template <size_t... Is> static constexpr size_t parallel_boundary() {
+    if constexpr (sizeof...(Is) > 0) {
+      return std::max({column_traits<NthType<Is>>::elements_per_cache_line...});
+    } else {
+      return std::max({column_traits<Ts>::elements_per_cache_line...});
+    }
+  }
+
+  // rounds grain up so that chunks of that many elements never share a cache
+  // line in any of the selected columns. This relies on the columns starting
+  // on a cache line, which is true for the default layout.
+  template <size_t... Is> static constexpr size_t parallel_grain(size_t grain) {
+    return round_up(std::max(grain, size_t(1)), parallel_boundary<Is...>());
+  }
+
+  // like map_range_static, but the range is split into chunks of about grain
+  // elements which are run in parallel, f may be called concurrently
+  template <size_t... Is, class F>
+  static void
+  parallel_map_range_static(void *base_array, size_t num_spots, F &&f,
+                            size_t start = 0,
+                            size_t end = std::numeric_limits<size_t>::max(),
+                            size_t grain = default_parallel_grain) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    parallel_map_range_columns<Is...>(
+        column_pointers_static(base_array, num_spots), f, start, end, grain);
+  }
+
+  template <size_t... Is, class F>
+  void parallel_map_range(F &&f, size_t start = 0,
+                          size_t end = std::numeric_limits<size_t>::max(),
+                          size_t grain = default_parallel_grain) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    parallel_map_range_columns<Is...>(column_starts, f, start, end, grain);
+  }
+
+  template <size_t... Is, class F>
+  static void parallel_map_range_with_index_static(
+      void *base_array, size_t num_spots, F &&f, size_t start = 0,
+      size_t end = std::numeric_limits<size_t>::max(),
+      size_t grain = default_parallel_grain) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    parallel_map_range_with_index_columns<Is...>(
+        column_pointers_static(base_array, num_spots), f, start, end, grain);
+  }
+
+  template <size_t... Is, class F>
+  void parallel_map_range_with_index(
+      F &&f, size_t start = 0, size_t end = std::numeric_limits<size_t>::max(),
+      size_t grain = default_parallel_grain) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    parallel_map_range_with_index_columns<Is...>(column_starts, f, start, end,
+                                                 grain);
+  }
+
+  // Calls f with the selected columns of only the rows in [start, end) whose
+  // flag in column FlagCol is set. A bit column is walked a set bit at a time,
+  // so runs of 64 clear rows are skipped with one test, any other column is
+  // tested row by row.
+  template <size_t FlagCol, size_t... Is, class F>
+  void map_range_where(F &&f, size_t start = 0,
+                       size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    map_range_where_columns<FlagCol, Is...>(column_starts, f, start, end);
+  }
+
+  // the flag column is only read, so only the selected columns decide the
+  // grain
+  template <size_t FlagCol, size_t... Is, class F>
+  void parallel_map_range_where(F &&f, size_t start = 0,
+                                size_t end = std::numeric_limits<size_t>::max(),
+                                size_t grain = default_parallel_grain) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    parallel_for_chunks(start, end, parallel_grain<Is...>(grain),
+                        [&](size_t lo, size_t hi) {
+                          map_range_where_columns<FlagCol, Is...>(column_starts,
+                                                                  f, lo, hi);
+                        });
+  }
+
+  // number of lanes in each batch given to map_range_simd, enough to fill a
+  // vector register with the widest of the selected columns
+  template <size_t... Is> static constexpr size_t simd_lanes() {
+    if constexpr (sizeof...(Is) > 0) {
+      return simd_lanes_for<native_value_t<NthType<Is>>...>;
+    } else {
+      return simd_lanes_for<native_value_t<Ts>...>;
+    }
+  }
+
+  // Like map_range_static, but f is called with one simd_batch per selected
+  // column holding simd_lanes<Is...>() consecutive elements. The last call
+  // may get partial batches, where only the first active lanes hold elements
+  // and the rest are zero. The batches are copies, so f cannot write through
+  // them.
+  template <size_t... Is, class F>
+  static void
+  map_range_simd_static(void *base_array, size_t num_spots, F &&f,
+                        size_t start = 0,
+                        size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    map_range_simd_columns<simd_lanes<Is...>()>(
+        column_pointers_static(base_array, num_spots), f, start, end,
+        selected_columns<Is...>());
+  }
+
+  template <size_t... Is, class F>
+  void map_range_simd(F &&f, size_t start = 0,
+                      size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    map_range_simd_columns<simd_lanes<Is...>()>(column_starts, f, start, end,
+                                                selected_columns<Is...>());
+  }
+
+  // Combines map(row) over the selected columns of every row in [start, end).
+  // identity must be the identity of combine, and combine must be associative
+  // and commutative since the rows are combined in no particular order.
+  template <size_t... Is, class R, class Map, class Combine>
+  static R reduce_static(void *base_array, size_t num_spots, R identity,
+                         Map &&map, Combine &&combine, size_t start = 0,
+                         size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    return reduce_columns<Is...>(column_pointers_static(base_array, num_spots),
+                                 identity, map, combine, start, end);
+  }
+
+  template <size_t... Is, class R, class Map, class Combine>
+  R reduce(R identity, Map &&map, Combine &&combine, size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return reduce_columns<Is...>(column_starts, identity, map, combine, start,
+                                 end);
+  }
+
+  // like reduce_static, but chunks of about grain rows are reduced in
+  // parallel and their partial results are combined at the end
+  template <size_t... Is, class R, class Map, class Combine>
+  static R parallel_reduce_static(
+      void *base_array, size_t num_spots, R identity, Map &&map,
+      Combine &&combine, size_t start = 0,
+      size_t end = std::numeric_limits<size_t>::max(),
+      size_t grain = default_parallel_grain) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_spots;
+    }
+    return parallel_reduce_columns<Is...>(
+        column_pointers_static(base_array, num_spots), identity, map, combine,
+        start, end, grain);
+  }
+
+  template <size_t... Is, class R, class Map, class Combine>
+  R parallel_reduce(R identity, Map &&map, Combine &&combine, size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return parallel_reduce_columns<Is...>(column_starts, identity, map,
+                                          combine, start, end, grain);
+  }
+
+  // the sum of every value in the selected columns
+  template <size_t... Is>
+  auto sum(size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    return sum_impl<false, Is...>(start, end, 0, selected_columns<Is...>());
+  }
+
+  template <size_t... Is>
+  auto parallel_sum(size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) const {
+    return sum_impl<true, Is...>(start, end, grain, selected_columns<Is...>());
+  }
+
+  // the smallest value in the selected columns
+  template <size_t... Is>
+  auto min(size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    return min_max_impl<false, true, Is...>(start, end, 0,
+                                            selected_columns<Is...>());
+  }
+
+  template <size_t... Is>
+  auto parallel_min(size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) const {
+    return min_max_impl<true, true, Is...>(start, end, grain,
+                                           selected_columns<Is...>());
+  }
+
+  // the largest value in the selected columns
+  template <size_t... Is>
+  auto max(size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    return min_max_impl<false, false, Is...>(start, end, 0,
+                                             selected_columns<Is...>());
+  }
+
+  template <size_t... Is>
+  auto parallel_max(size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) const {
+    return min_max_impl<true, false, Is...>(start, end, grain,
+                                            selected_columns<Is...>());
+  }
+
+  // The number of rows where pred, called with the selected columns, is true.
+  // On a single dictionary encoded column pred is called once per value in
+  // the dictionary and only the codes of the rows are read.
+  template <size_t... Is, class F>
+  size_t count_if(F &&pred, size_t start = 0,
+                  size_t end = std::numeric_limits<size_t>::max()) const {
+    if constexpr (dictionary_column<Is...>()) {
+      return count_matching_codes<false, Is...>(pred, start, end, 0);
+    } else {
+      return reduce<Is...>(
+          size_t(0),
+          [&pred](const auto &...args) -> size_t {
+            return pred(args...) ? 1 : 0;
+          },
+          std::plus<>(), start, end);
+    }
+  }
+
+  template <size_t... Is, class F>
+  size_t parallel_count_if(F &&pred, size_t start = 0,
+                           size_t end = std::numeric_limits<size_t>::max(),
+                           size_t grain = default_parallel_grain) const {
+    if constexpr (dictionary_column<Is...>()) {
+      return count_matching_codes<true, Is...>(pred, start, end, grain);
+    } else {
+      return parallel_reduce<Is...>(
+          size_t(0),
+          [&pred](const auto &...args) -> size_t {
+            return pred(args...) ? 1 : 0;
+          },
+          std::plus<>(), start, end, grain);
+    }
+  }
+
+  // The number of rows in [start, end) with each value of column I, which
+  // must be dictionary encoded, as (value, count) pairs in the order the
+  // values were first written. Only the codes of the rows are read.
+  template <size_t I>
+  auto value_counts(size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max()) const {
+    static_assert(dictionary_column<I>(),
+                  "only dictionary columns know their values");
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    const auto &column = std::get<I>(column_starts);
+    std::vector<size_t> counts(column.dictionary_size());
+    column.count_codes(start, end, counts.data());
+    std::vector<
+        std::pair<typename column_traits<NthType<I>>::value_type, size_t>>
+        result;
+    for (size_t code = 0; code < counts.size(); code++) {
+      if (counts[code] > 0) {
+        result.emplace_back(column.value(code), counts[code]);
+      }
+    }
+    return result;
+  }
+
+  // The number of rows in [start, end) whose flag in column I is set. Column I
+  // must be a bit column, which is counted a word at a time.
+  template <size_t I>
+  size_t count(size_t start = 0,
+               size_t end = std::numeric_limits<size_t>::max()) const {
+    static_assert(BitColumn<column_pointer_t<NthType<I>>>,
+                  "only bit columns are counted a word at a time");
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return std::get<I>(column_starts).count(start, end);
+  }
+
+  // whether any row in [start, end) has its flag in column I set
+  template <size_t I>
+  bool any(size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    static_assert(BitColumn<column_pointer_t<NthType<I>>>,
+                  "only bit columns are searched a word at a time");
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return std::get<I>(column_starts).any(start, end);
+  }
+
+  // whether every row in [start, end) has its flag in column I set, true for an
+  // empty range
+  template <size_t I>
+  bool all(size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    static_assert(BitColumn<column_pointer_t<NthType<I>>>,
+                  "only bit columns are searched a word at a time");
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return std::get<I>(column_starts).all(start, end);
+  }
+
+  // the first row in [start, end) with its flag in column I set, or end if
+  // there is none
+  template <size_t I>
+  size_t find_next(size_t start = 0,
+                   size_t end = std::numeric_limits<size_t>::max()) const {
+    static_assert(BitColumn<column_pointer_t<NthType<I>>>,
+                  "only bit columns are searched a word at a time");
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return std::get<I>(column_starts).find_next(start, end);
+  }
+
+  // sorts the rows by the values in column K, comp compares two keys
+  template <size_t K, class Compare = std::less<>>
+  void sort_by(Compare comp = Compare()) {
+    comparison_sort_by<K, false, false>(comp, 0);
+  }
+
+  // like sort_by, but rows with equal keys keep their relative order
+  template <size_t K, class Compare = std::less<>>
+  void stable_sort_by(Compare comp = Compare()) {
+    comparison_sort_by<K, true, false>(comp, 0);
+  }
+
+  template <size_t K, class Compare = std::less<>>
+  void parallel_sort_by(Compare comp = Compare(),
+                        size_t grain = default_parallel_grain) {
+    comparison_sort_by<K, false, true>(comp, grain);
+  }
+
+  template <size_t K, class Compare = std::less<>>
+  void parallel_stable_sort_by(Compare comp = Compare(),
+                               size_t grain = default_parallel_grain) {
+    comparison_sort_by<K, true, true>(comp, grain);
+  }
+
+  // sorts the rows by the integer column K in increasing order with a least
+  // significant digit radix sort, one pass per byte of the key. Like
+  // stable_sort_by, rows with equal keys keep their relative order.
+  template <size_t K> void radix_sort_by() { radix_sort_by_impl<K, false>(0); }
+
+  // the digit counts of each chunk are taken in parallel, and a prefix sum
+  // over them gives every chunk its own place to scatter to
+  template <size_t K>
+  void parallel_radix_sort_by(size_t grain = default_parallel_grain) {
+    radix_sort_by_impl<K, true>(grain);
+  }
+
+  // Removes every row where pred, called with the selected columns, is true,
+  // keeping the order of the rest, and returns how many were removed. pred is
+  // evaluated for every row first and then each column is compacted in one
+  // pass.
+  template <size_t... Is, class F> size_t erase_if(F &&pred) {
+    return erase_if_impl<false, Is...>(pred, 0);
+  }
+
+  template <size_t... Is, class F>
+  size_t parallel_erase_if(F &&pred, size_t grain = default_parallel_grain) {
+    return erase_if_impl<true, Is...>(pred, grain);
+  }
+
+  // Moves the rows where pred is true in front of the others, keeping the
+  // order within each group, and returns how many rows pred was true for.
+  template <size_t... Is, class F> size_t partition(F &&pred) {
+    return partition_impl<false, Is...>(pred, 0);
+  }
+
+  template <size_t... Is, class F>
+  size_t parallel_partition(F &&pred, size_t grain = default_parallel_grain) {
+    return partition_impl<true, Is...>(pred, grain);
+  }
+
+  // Appends the rows where pred is true to dest, in order, and returns how
+  // many were appended.
+  template <size_t... Is, class F>
+  size_t filter_into(BasicSOA &dest, F &&pred) const {
+    return filter_into_impl<false, Is...>(dest, pred, 0);
+  }
+
+  template <size_t... Is, class F>
+  size_t parallel_filter_into(BasicSOA &dest, F &&pred,
+                              size_t grain = default_parallel_grain) const {
+    return filter_into_impl<true, Is...>(dest, pred, grain);
+  }
+
+  template <size_t... Is>
+  static void
+  print_aos_static(void *base_array, size_t num_spots,
+                   size_t end = std::numeric_limits<size_t>::max()) {
+    map_range_static<Is...>(
+        base_array, num_spots,
+        [](auto... args) { ((std::cout << args << ","), ...) << "\n"; }, 0,
+        end);
+  }
+
+  template <size_t... Is> void print_aos() const {
+    print_aos_static<Is...>(base_array, num_spots, num_elements);
+  }
+
+  template <size_t... Is>
+  static void
+  print_aos_with_index_static(void *base_array, size_t num_spots,
+                              size_t end = std::numeric_limits<size_t>::max()) {
+    map_range_with_index_static<Is...>(
+        base_array, num_spots,
+        [](auto... args) { ((std::cout << args << ","), ...) << "\n"; }, 0,
+        end);
+  }
+
+  template <size_t... Is> void print_aos_with_index() const {
+    print_aos_with_index_static<Is...>(base_array, num_spots, num_elements);
+  }
+
+  // make room for at least new_num_spots elements without changing size()
+  void reserve(size_t new_num_spots) {
+    if (new_num_spots > num_spots) {
+      reallocate(new_num_spots);
+    }
+  }
+
+  // release any capacity beyond size()
+  void shrink_to_fit() {
+    if (num_elements < num_spots) {
+      reallocate(num_elements);
+    }
+  }
+
+  // encoded columns are zeroed again, since blocks such as those of
+  // frame_uint are written relative to the rows already in them
+  void clear() {
+    if (base_array != nullptr) {
+      zero_encoded_tails_static(base_array, num_spots, 0,
+                                std::make_index_sequence<num_types>{});
+    }
+    num_elements = 0;
+  }
+
+  void push_back(const T &v) {
+    grow_to_fit(num_elements + 1);
+    get_from_columns(column_starts, num_elements) = v;
+    num_elements += 1;
+  }
+
+  template <class... Args> void emplace_back(Args &&...args) {
+    static_assert(sizeof...(Args) == num_types);
+    grow_to_fit(num_elements + 1);
+    get_from_columns(column_starts, num_elements) =
+        std::forward_as_tuple(std::forward<Args>(args)...);
+    num_elements += 1;
+  }
+
+  // appends every element of range, each element must be assignable to T.
+  // Another BasicSOA, const or not, is appended by the overload below.
+  template <class R>
+    requires(!std::same_as<std::remove_cvref_t<R>, BasicSOA>)
+  void append(R &&range) {
+    if constexpr (std::ranges::sized_range<R>) {
+      grow_to_fit(num_elements + std::ranges::size(range));
+    }
+    for (auto &&e : range) {
+      push_back(e);
+    }
+  }
+
+  // Appends all of the elements of other, one bulk copy per column. Returns
+  // false if an encoded column with a limited range such as frame_uint could
+  // not represent the new rows next to the ones already in their block, as
+  // assign does.
+  bool append(const BasicSOA &other) {
+    grow_to_fit(num_elements + other.num_elements);
+    bool appended = append_impl(other, std::make_index_sequence<num_types>{});
+    num_elements += other.num_elements;
+    return appended;
+  }
+
+  // Opens count rows at pos by moving rows [pos, size()) up by count, one
+  // memmove per column, and grows the capacity geometrically if needed. The
+  // rows of the gap keep whatever they held until they are written, as insert
+  // does.
+  void shift(size_t pos, size_t count) {
+    static_assert(plain_columns(), "rows are moved a column at a time");
+    grow_to_fit(num_elements + count);
+    move_rows(pos, pos + count, num_elements - pos,
+              std::make_index_sequence<num_types>{});
+    num_elements += count;
+  }
+
+  // inserts v before row pos
+  void insert(size_t pos, const T &v) {
+    shift(pos, 1);
+    get_from_columns(column_starts, pos) = v;
+  }
+
+  // inserts all of the rows of other before row pos, after a single shift
+  // each column of other is copied in bulk
+  void insert(size_t pos, const BasicSOA &other) {
+    if (&other == this) {
+      insert(pos, other.clone());
+      return;
+    }
+    shift(pos, other.num_elements);
+    insert_columns(pos, other, std::make_index_sequence<num_types>{});
+  }
+
+  // Inserts every element of range before row pos, each element must be
+  // assignable to T. Another BasicSOA goes to insert(pos, other) and is
+  // copied a column at a time. Only a contiguous range, such as a vector of
+  // T, is read after the shift. Anything else may be a view of, or iterators
+  // into, this table, which the shift moves or frees, so it is copied into a
+  // new table first.
+  template <class R> void insert_range(size_t pos, R &&range) {
+    if constexpr (std::same_as<std::remove_cvref_t<R>, BasicSOA>) {
+      insert(pos, std::as_const(range));
+    } else if constexpr (std::ranges::contiguous_range<R> &&
+                         std::ranges::sized_range<R>) {
+      shift(pos, std::ranges::size(range));
+      for (auto &&e : range) {
+        get_from_columns(column_starts, pos++) = e;
+      }
+    } else {
+      BasicSOA rows(allocator);
+      rows.append(range);
+      insert(pos, rows);
+    }
+  }
+
+  // removes rows [first, last), moving the rows after them down with one
+  // memmove per column, the capacity is kept
+  void erase(size_t first, size_t last) {
+    static_assert(plain_columns(), "rows are moved a column at a time");
+    move_rows(last, first, num_elements - last,
+              std::make_index_sequence<num_types>{});
+    num_elements -= last - first;
+  }
+
+  static void *resize_static(void *old_base_array, size_t old_num_spots,
+                             size_t new_num_spots,
+                             Allocator allocator = Allocator()) {
+    return resize_impl_static(old_base_array, old_num_spots, new_num_spots,
+                              std::make_index_sequence<num_types>{},
+                              std::numeric_limits<size_t>::max(), allocator);
+  }
+
+  BasicSOA resize(size_t new_num_spots) const {
+    return BasicSOA(resize_impl_static(base_array, num_spots, new_num_spots,
+                                       std::make_index_sequence<num_types>{},
+                                       num_elements, allocator),
+                    new_num_spots, allocator);
+  }
+  template <size_t... Is>
+  static void *
+  pull_types_static(void *base_array, size_t num_spots,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    Allocator allocator = Allocator()) {
     if (end == std::numeric_limits<size_t>::max()) {
       end = num_spots;
     }
-    for (size_t i = start; i < end; i++) {
-      std::apply(f,
-                 std::tuple_cat(std::make_tuple(i),
-                                get_static<Is...>(base_array, num_spots, i)));
-    }
-  }
 
-  template <size_t... Is, class F>
-  void
-  map_range_with_index(F &&f, size_t start = 0,
-                       size_t end = std::numeric_limits<size_t>::max()) const {
-    map_range_with_index_static<Is...>(base_array, num_spots, f, start, end);
-  }
+    using projected = BasicSOA<Layout, Allocator, NthType<Is>...>;
+    uintptr_t length_to_allocate = projected::get_size_static(end);
+    void *new_base_array =
+        allocator.allocate(length_to_allocate, projected::base_alignment);
+    projected::zero_padding_static(new_base_array, end);
 
+    const auto new_columns =
+        projected::column_pointers_static(new_base_array, end);
+    const ColumnPointers columns =
+        column_pointers_static(base_array, num_spots);
+    for (size_t i = 0; i < end; i++) {
+      projected::get_from_columns(new_columns, i) =
+          get_from_columns<Is...>(columns, i);
+    }
+    return new_base_array;
+  }
   template <size_t... Is>
-  static void print_aos_static(void *base_array, size_t num_spots) {
-    map_range_static<Is...>(base_array, num_spots, [](auto... args) {
-      ((std::cout << args << ","), ...) << "\n";
-    });
+  BasicSOA<Layout, Allocator, NthType<Is>...> pull_types() const {
+    BasicSOA<Layout, Allocator, NthType<Is>...> soa(
+        pull_types_static<Is...>(base_array, num_spots, num_elements,
+                                 allocator),
+        num_elements, allocator);
+    return soa;
   }
 
-  template <size_t... Is> void print_aos() const {
-    print_aos_static(base_array, num_spots);
+  // A view of the selected columns, all of them if none are given, over rows
+  // [start, end). Unlike pull_types nothing is copied, the view reads and
+  // writes the rows of this container and is invalidated when it reallocates.
+  template <size_t... Is>
+  auto view(size_t start = 0, size_t end = std::numeric_limits<size_t>::max()) {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return view_impl<false>(start, end, selected_columns<Is...>());
   }
 
+  // a const container only gives out views that read its rows
   template <size_t... Is>
-  static void print_aos_with_index_static(void *base_array, size_t num_spots) {
-    map_range_with_index_static<Is...>(base_array, num_spots, [](auto... args) {
-      ((std::cout << args << ","), ...) << "\n";
-    });
+  auto view(size_t start = 0,
+            size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return view_impl<true>(start, end, selected_columns<Is...>());
   }
 
-  template <size_t... Is> void print_aos_with_index() const {
-    print_aos_with_index_static<Is...>(base_array, num_spots);
+  // Writes the size, the size and alignment of every column and then each
+  // column as one contiguous extent to fd, all with pwritev so the columns go
+  // straight from the container to the file. The offsets in the file count
+  // from its start, as load reads them, so it is always written from offset 0
+  // whatever the position of fd, which is left as it was. Bytes past the end
+  // of the table in a longer existing file are left alone and never read. The
+  // format is described in internal/io.hpp.
+  bool save(int fd) const {
+    static_assert(trivially_copyable && plain_columns(),
+                  "saved columns are written as raw bytes");
+    SavedSOAHeader header = {SavedSOAHeader::expected_magic,
+                             SavedSOAHeader::current_version, num_types,
+                             num_elements};
+    std::array<SavedSOAColumn, num_types> table;
+    std::array<iovec, num_types + 2> iov;
+    iov[0] = {&header, sizeof(header)};
+    iov[1] = {table.data(), sizeof(table)};
+    uint64_t offset = sizeof(header) + sizeof(table);
+    std::apply(
+        [&](auto *...columns) {
+          size_t i = 0;
+          ((table[i] = {sizes[i], alignments[i], offset},
+            iov[i + 2] = {columns, num_elements * sizes[i]},
+            offset += num_elements * sizes[i], i++),
+           ...);
+        },
+        column_starts);
+    return write_all_at(fd, iov.data(), iov.size(), 0);
   }
 
-  static void *resize_static(void *old_base_array, size_t old_num_spots,
-                             size_t new_num_spots) {
-    return resize_impl_static(old_base_array, old_num_spots, new_num_spots,
-                              std::make_index_sequence<num_types>{});
+  bool save(const char *path) const {
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return false;
+    }
+    bool saved = save(fd);
+    return (::close(fd) == 0) && saved;
   }
 
-  SOA resize(size_t new_num_spots) const {
-    return SOA(resize_static(base_array, num_spots, new_num_spots),
-               new_num_spots);
+private:
+  // Reads the selected columns of a file written by save into the columns of
+  // out. The extents are sorted by where they are in the file and neighbouring
+  // ones are read with a single preadv, the other columns are never read.
+  template <class Out, size_t... Is, size_t... Js>
+  static bool load_impl(
+      int fd, Out &out,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> columns,
+      [[maybe_unused]] std::integer_sequence<size_t, Js...> positions) {
+    SavedSOAHeader header = {};
+    std::array<SavedSOAColumn, num_types> table;
+    std::array<iovec, 2> header_iov = {
+        {{&header, sizeof(header)}, {table.data(), sizeof(table)}}};
+    if (!read_all_at(fd, header_iov.data(), header_iov.size(), 0)) {
+      return false;
+    }
+    if (header.magic != SavedSOAHeader::expected_magic ||
+        header.version != SavedSOAHeader::current_version ||
+        header.num_types != num_types) {
+      return false;
+    }
+    for (size_t i = 0; i < num_types; i++) {
+      if (table[i].size != sizes[i] || table[i].alignment != alignments[i]) {
+        return false;
+      }
+    }
+    struct stat file_stat = {};
+    if (fstat(fd, &file_stat) != 0) {
+      return false;
+    }
+    uint64_t file_size = file_stat.st_size;
+    uint64_t n = header.num_elements;
+    for (size_t i : {Is...}) {
+      if (n > file_size / sizes[i] || table[i].offset > file_size ||
+          n * sizes[i] > file_size - table[i].offset) {
+        return false;
+      }
+    }
+
+    out.clear();
+    out.reserve(n);
+    out.num_elements = n;
+    struct Extent {
+      uint64_t offset;
+      iovec iov;
+    };
+    std::array<Extent, sizeof...(Is)> extents = {
+        {{table[Is].offset,
+          {std::get<Js>(out.column_starts), n * sizes[Is]}}...}};
+    std::sort(extents.begin(), extents.end(),
+              [](const Extent &a, const Extent &b) {
+                return a.offset < b.offset;
+              });
+    std::array<iovec, sizeof...(Is)> iov;
+    for (size_t run_start = 0; run_start < extents.size();) {
+      size_t run_end = run_start;
+      uint64_t next_offset = extents[run_start].offset;
+      while (run_end < extents.size() &&
+             extents[run_end].offset == next_offset) {
+        iov[run_end - run_start] = extents[run_end].iov;
+        next_offset += extents[run_end].iov.iov_len;
+        run_end++;
+      }
+      if (!read_all_at(fd, iov.data(), run_end - run_start,
+                       extents[run_start].offset)) {
+        out.clear();
+        return false;
+      }
+      run_start = run_end;
+    }
+    return true;
   }
-  template <size_t... Is>
-  static void *pull_types_static(void *base_array, size_t num_spots) {
 
-    uintptr_t length_to_allocate =
-        SOA<NthType<Is>...>::get_size_static(num_spots);
-    void *new_base_array = std::malloc(length_to_allocate);
+public:
+  // Replaces the contents of out with the selected columns, all of them if
+  // none are given, of a file written by save from a BasicSOA with the same
+  // types, like pull_types does in memory. Only the selected columns are read
+  // from the file. Returns false if the file does not hold columns of these
+  // types or could not be read.
+  template <size_t... Is>
+  static bool load(int fd, Projection<Is...> &out) {
+    static_assert(trivially_copyable && plain_columns(),
+                  "saved columns are read as raw bytes");
+    return load_impl(fd, out, selected_columns<Is...>(),
+                     std::make_index_sequence<Projection<Is...>::num_types>{});
+  }
 
-    for (size_t i = 0; i < num_spots; i++) {
-      SOA<NthType<Is>...>::get_static(new_base_array, num_spots, i) =
-          get_static<Is...>(base_array, num_spots, i);
+  template <size_t... Is>
+  static bool load(const char *path, Projection<Is...> &out) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      return false;
     }
-    return new_base_array;
-  }
-  template <size_t... Is> SOA<NthType<Is>...> pull_types() const {
-    SOA<NthType<Is>...> soa(pull_types_static<Is...>(base_array, num_spots),
-                            num_spots);
-    return soa;
+    bool loaded = load<Is...>(fd, out);
+    ::close(fd);
+    return loaded;
   }
 
+  // the iterator and its references carry the column starts, so moving
+  // through the container or reading through a reference never has to work
+  // out the column offsets
   class Iterator {
 
   public:
@@ -354,47 +2403,54 @@ public:
     using iterator_category = std::random_access_iterator_tag;
 
     struct reference {
-      void *_array;
-      size_t _spots;
+      ColumnPointers _columns;
       uint64_t _index;
 
       reference &operator=(reference &&v) {
-        get_static(_array, _spots, _index) =
-            get_static(v._array, v._spots, v._index);
+        get_from_columns(_columns, _index) =
+            get_from_columns(v._columns, v._index);
         return *this;
       }
       reference &operator=(const value_type &v) {
-        get_static(_array, _spots, _index) = v;
+        get_from_columns(_columns, _index) = v;
         return *this;
       }
 
-      operator value_type() const { return get_static(_array, _spots, _index); }
+      operator value_type() const { return get_from_columns(_columns, _index); }
 
       template <size_t... Is> auto get() {
-        return get_static<Is...>(_array, _spots, _index);
+        return get_from_columns<Is...>(_columns, _index);
+      }
+
+      // the row as a tuple of references
+      [[nodiscard]] auto row() const {
+        return get_from_columns(_columns, _index);
       }
 
       friend void swap(const reference &l, const reference &r) {
-        T temp = get_static(l._array, l._spots, l._index);
-        get_static(l._array, l._spots, l._index) =
-            get_static(r._array, r._spots, r._index);
-        get_static(r._array, r._spots, r._index) = temp;
+        T temp = l.row();
+        l.row() = r.row();
+        r.row() = temp;
       }
 
       auto operator<(const reference &b) const {
-        return value_type() < value_type(b);
+        return value_type(*this) < value_type(b);
       }
-      auto operator<(const T &b) const { return value_type() < b; }
+      auto operator<(const T &b) const { return value_type(*this) < b; }
       friend auto operator<(const T &b, const reference &a) {
         return b < value_type(a);
       }
 
+      reference(const ColumnPointers &columns, uint64_t index)
+          : _columns(columns), _index(index) {}
       reference(void *array, uint64_t spots, uint64_t index)
-          : _array(array), _spots(spots), _index(index) {}
+          : _columns(column_pointers_static(array, spots)), _index(index) {}
     };
 
+    Iterator(const ColumnPointers &columns, uint64_t index)
+        : _columns(columns), _index(index) {}
     Iterator(void *array, uint64_t spots, uint64_t index)
-        : _array(array), _spots(spots), _index(index) {}
+        : _columns(column_pointers_static(array, spots)), _index(index) {}
 
     inline Iterator &operator+=(difference_type rhs) {
       _index += rhs;
@@ -405,11 +2461,9 @@ public:
       return *this;
     }
 
-    inline reference operator*() const {
-      return reference(_array, _spots, _index);
-    }
+    inline reference operator*() const { return reference(_columns, _index); }
     inline reference operator[](difference_type rhs) const {
-      return reference(_array, _spots, _index + rhs);
+      return reference(_columns, _index + rhs);
     }
 
     inline Iterator &operator++() {
@@ -435,16 +2489,16 @@ public:
       return _index - rhs._index;
     }
     inline Iterator operator+(difference_type rhs) const {
-      return Iterator(_array, _spots, _index + rhs);
+      return Iterator(_columns, _index + rhs);
     }
     inline Iterator operator-(difference_type rhs) const {
-      return Iterator(_array, _spots, _index - rhs);
+      return Iterator(_columns, _index - rhs);
     }
     friend inline Iterator operator+(difference_type lhs, const Iterator &rhs) {
-      return Iterator(rhs._array, rhs._spots, lhs + rhs._index);
+      return Iterator(rhs._columns, lhs + rhs._index);
     }
     friend inline Iterator operator-(difference_type lhs, const Iterator &rhs) {
-      return Iterator(rhs._array, rhs._spots, lhs - rhs._index);
+      return Iterator(rhs._columns, lhs - rhs._index);
     }
 
     inline bool operator==(const Iterator &rhs) const {
@@ -467,18 +2521,564 @@ public:
     }
 
   private:
-    void *_array;
-    size_t _spots;
+    ColumnPointers _columns;
     uint64_t _index = 0;
   };
 
   static Iterator begin_static(void *base_array, size_t num_spots) {
     return Iterator(base_array, num_spots, 0);
   }
-  auto begin() const { return begin_static(base_array, num_spots); }
+  auto begin() const { return Iterator(column_starts, 0); }
 
   static Iterator end_static(void *base_array, size_t num_spots) {
     return Iterator(base_array, num_spots, num_spots);
   }
-  auto end() const { return end_static(base_array, num_spots); }
+  auto end() const { return Iterator(column_starts, num_elements); }
+};
+
+// A non owning view of some of the columns of a BasicSOA over a range of its
+// rows, made by BasicSOA::view. Making one copies only the column starts. Row
+// i of the view is row start + i of the container, and reads and writes go
+// straight to the container, so a view is only valid until the container
+// reallocates or is destroyed. Views are cheap to copy and to narrow further,
+// such as into one view per chunk of rows for parallel work.
+//
+// A ReadOnly view, which is what a const BasicSOA gives out, hands out its
+// rows as const references, or as values for encoded columns, calls f with
+// const arguments, and cannot sort.
+template <bool ReadOnly, typename... Ts> class BasicSOAView {
+  template <typename, typename, typename...> friend class BasicSOA;
+  template <bool, typename...> friend class BasicSOAView;
+
+  // the column loops of a BasicSOA only depend on the column starts they are
+  // given, so the view runs those of a BasicSOA with its types
+  using Columns = BasicSOA<SOALayout<>, MallocAllocator, Ts...>;
+  using ColumnPointers = typename Columns::ColumnPointers;
+  using T = std::tuple<Ts...>;
+  template <int I> using NthType = typename std::tuple_element<I, T>::type;
+
+  ColumnPointers columns;
+  size_t offset = 0;
+  size_t num_elements = 0;
+
+  BasicSOAView(const ColumnPointers &c, size_t start, size_t n)
+      : columns(c), offset(start), num_elements(n) {}
+
+  // passes f the index of the row in the view rather than in the container,
+  // and is only invocable with what f is, so the loops still pick between
+  // reading in place and by block the same way
+  template <class F> struct view_index {
+    F &f;
+    size_t offset;
+
+    template <class... Args>
+    auto operator()(size_t i, Args &&...args) const
+        -> decltype(f(i, std::forward<Args>(args)...)) {
+      return f(i - offset, std::forward<Args>(args)...);
+    }
+  };
+
+  // passes f its arguments as const, and like view_index is only invocable
+  // with what f is
+  template <class F> struct const_arguments {
+    F &f;
+
+    template <class... Args>
+    auto operator()(Args &&...args) const
+        -> decltype(f(static_cast<const std::remove_reference_t<Args> &>(
+            args)...)) {
+      return f(static_cast<const std::remove_reference_t<Args> &>(args)...);
+    }
+  };
+
+  // what the column loops call in place of f
+  template <class F> static decltype(auto) rows_function(F &f) {
+    if constexpr (ReadOnly) {
+      return const_arguments<F>{f};
+    } else {
+      return (f);
+    }
+  }
+
+  // what row i of column I is read as from a read only view
+  template <size_t I>
+  using read_type = std::conditional_t<EncodedColumn<NthType<I>>, NthType<I>,
+                                       const NthType<I> &>;
+
+  template <size_t... Is>
+  auto read_only_row(
+      size_t i,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) const {
+    return std::tuple<read_type<Is>...>(std::get<0>(
+        Columns::template get_from_columns<Is>(columns, offset + i))...);
+  }
+
+  template <size_t... Is>
+  BasicSOAView<ReadOnly, NthType<Is>...>
+  view_impl(size_t start, size_t end,
+            [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq)
+      const {
+    using View = BasicSOAView<ReadOnly, NthType<Is>...>;
+    return View(typename View::ColumnPointers(std::get<Is>(columns)...),
+                offset + start, end - start);
+  }
+
+  // the count_if of a single dictionary column, as BasicSOA does it
+  template <bool Parallel, size_t I, class F>
+  size_t count_matching_codes(F &&pred, size_t start, size_t end,
+                              size_t grain) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    const auto &column = std::get<I>(columns);
+    auto match = column.match(pred);
+    auto count_chunk = [&](size_t lo, size_t hi) {
+      return column.count_matching(match, lo, hi);
+    };
+    if constexpr (Parallel) {
+      return parallel_reduce_chunks(
+          offset + start, offset + end,
+          Columns::template parallel_grain<I>(grain), size_t(0), count_chunk,
+          std::plus<>());
+    } else {
+      return count_chunk(offset + start, offset + end);
+    }
+  }
+
+  template <size_t I> const auto &bit_column() const {
+    static_assert(BitColumn<column_pointer_t<NthType<I>>>,
+                  "only bit columns are searched a word at a time");
+    return std::get<I>(columns);
+  }
+
+  // puts rows [0, size()) of column I in the order given by keyed, a vector
+  // of (key, row) pairs
+  template <size_t I, bool Parallel, class Keyed>
+  void permute_column(const Keyed &keyed, size_t grain) const {
+    NthType<I> *column = std::get<I>(columns) + offset;
+    std::vector<NthType<I>> sorted(num_elements);
+    auto gather = [&](size_t lo, size_t hi) {
+      for (size_t i = lo; i < hi; i++) {
+        sorted[i] = column[keyed[i].second];
+      }
+    };
+    if constexpr (Parallel) {
+      parallel_for_chunks(0, num_elements, grain, gather);
+    } else {
+      gather(0, num_elements);
+    }
+    std::copy(sorted.begin(), sorted.end(), column);
+  }
+
+  template <bool Parallel, class Keyed, size_t... Is>
+  void permute_rows(
+      const Keyed &keyed, size_t grain,
+      [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq) const {
+    (permute_column<Is, Parallel>(keyed, grain), ...);
+  }
+
+  // Like BasicSOA::sort_by, the keys are sorted with the row they came from,
+  // but a view cannot swap in a new array, so each column is gathered into a
+  // buffer in the new order and copied back. sort_keys is called with the
+  // vector of (key, row) pairs and must sort it by key.
+  template <size_t K, bool Parallel, class SortKeys>
+  void sort_by_impl(SortKeys &&sort_keys, size_t grain) const {
+    static_assert(!ReadOnly, "a read only view cannot reorder its rows");
+    static_assert(Columns::plain_columns(),
+                  "sorting moves the elements of every column");
+    std::vector<std::pair<sort_key_t<NthType<K>>, size_t>> keyed(num_elements);
+    const NthType<K> *keys = std::get<K>(columns) + offset;
+    for (size_t i = 0; i < num_elements; i++) {
+      keyed[i] = {keys[i], i};
+    }
+    sort_keys(keyed);
+    permute_rows<Parallel>(keyed, grain, std::make_index_sequence<num_types>{});
+  }
+
+  template <size_t K, bool Stable, bool Parallel, class Compare>
+  void comparison_sort_by(Compare comp, size_t grain) const {
+    auto by_key = [&comp](const auto &a, const auto &b) {
+      return comp(a.first, b.first);
+    };
+    sort_by_impl<K, Parallel>(
+        [&](auto &keyed) {
+          if constexpr (Parallel) {
+            parallel_sort<Stable>(keyed.begin(), keyed.end(), by_key, grain);
+          } else if constexpr (Stable) {
+            std::stable_sort(keyed.begin(), keyed.end(), by_key);
+          } else {
+            std::sort(keyed.begin(), keyed.end(), by_key);
+          }
+        },
+        grain);
+  }
+
+  template <size_t K, bool Parallel>
+  void radix_sort_by_impl(size_t grain) const {
+    using Key = sort_key_t<NthType<K>>;
+    static_assert(std::is_integral_v<Key> && !std::is_same_v<Key, bool>,
+                  "radix sort needs an integer key column");
+    sort_by_impl<K, Parallel>(
+        [&](auto &keyed) {
+          radix_sort<sizeof(NthType<K>), Parallel>(
+              keyed, [](const auto &e) { return radix_key(e.first); }, grain);
+        },
+        grain);
+  }
+
+public:
+  static constexpr std::size_t num_types = sizeof...(Ts);
+
+  BasicSOAView() = default;
+
+  // a view that writes can always be read only
+  operator BasicSOAView<true, Ts...>() const {
+    return BasicSOAView<true, Ts...>(columns, offset, num_elements);
+  }
+
+  [[nodiscard]] size_t size() const { return num_elements; }
+
+  [[nodiscard]] bool empty() const { return num_elements == 0; }
+
+  // the selected columns of row i as a tuple of references, which are const
+  // for a read only view
+  template <size_t... Is> auto get(size_t i) const {
+    if constexpr (ReadOnly) {
+      return read_only_row(i, Columns::template selected_columns<Is...>());
+    } else {
+      return Columns::template get_from_columns<Is...>(columns, offset + i);
+    }
+  }
+
+  // the rows of plain column I that the view covers
+  template <size_t I>
+  std::span<std::conditional_t<ReadOnly, const NthType<I>, NthType<I>>>
+  column() const {
+    static_assert(Columns::template plain_columns<I>(),
+                  "elements of encoded columns have no address");
+    return {std::get<I>(columns) + offset, num_elements};
+  }
+
+  // a view of the selected columns of rows [start, end) of this view
+  template <size_t... Is>
+  auto view(size_t start = 0,
+            size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return view_impl(start, end, Columns::template selected_columns<Is...>());
+  }
+
+  template <size_t... Is, class F>
+  void map_range(F &&f, size_t start = 0,
+                 size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    Columns::template map_range_columns<Is...>(columns, rows_function(f),
+                                               offset + start, offset + end);
+  }
+
+  template <size_t... Is, class F>
+  void
+  map_range_with_index(F &&f, size_t start = 0,
+                       size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    auto &&g = rows_function(f);
+    Columns::template map_range_with_index_columns<Is...>(
+        columns, view_index<std::remove_reference_t<decltype(g)>>{g, offset},
+        offset + start, offset + end);
+  }
+
+  template <size_t... Is, class F>
+  void parallel_map_range(F &&f, size_t start = 0,
+                          size_t end = std::numeric_limits<size_t>::max(),
+                          size_t grain = default_parallel_grain) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    Columns::template parallel_map_range_columns<Is...>(
+        columns, rows_function(f), offset + start, offset + end, grain);
+  }
+
+  template <size_t... Is, class F>
+  void parallel_map_range_with_index(
+      F &&f, size_t start = 0, size_t end = std::numeric_limits<size_t>::max(),
+      size_t grain = default_parallel_grain) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    auto &&g = rows_function(f);
+    Columns::template parallel_map_range_with_index_columns<Is...>(
+        columns, view_index<std::remove_reference_t<decltype(g)>>{g, offset},
+        offset + start, offset + end, grain);
+  }
+
+  template <size_t... Is, class R, class Map, class Combine>
+  R reduce(R identity, Map &&map, Combine &&combine, size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return Columns::template reduce_columns<Is...>(
+        columns, identity, rows_function(map), combine, offset + start,
+        offset + end);
+  }
+
+  template <size_t... Is, class R, class Map, class Combine>
+  R parallel_reduce(R identity, Map &&map, Combine &&combine, size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return Columns::template parallel_reduce_columns<Is...>(
+        columns, identity, rows_function(map), combine, offset + start,
+        offset + end, grain);
+  }
+
+  // the sum of every value in the selected columns
+  template <size_t... Is>
+  auto sum(size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    return sum_impl<false, Is...>(
+        start, end, 0, Columns::template selected_columns<Is...>());
+  }
+
+  template <size_t... Is>
+  auto parallel_sum(size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) const {
+    return sum_impl<true, Is...>(start, end, grain,
+                                 Columns::template selected_columns<Is...>());
+  }
+
+  // the smallest value in the selected columns
+  template <size_t... Is>
+  auto min(size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    return min_max_impl<false, true, Is...>(
+        start, end, 0, Columns::template selected_columns<Is...>());
+  }
+
+  template <size_t... Is>
+  auto parallel_min(size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) const {
+    return min_max_impl<true, true, Is...>(
+        start, end, grain, Columns::template selected_columns<Is...>());
+  }
+
+  // the largest value in the selected columns
+  template <size_t... Is>
+  auto max(size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    return min_max_impl<false, false, Is...>(
+        start, end, 0, Columns::template selected_columns<Is...>());
+  }
+
+  template <size_t... Is>
+  auto parallel_max(size_t start = 0,
+                    size_t end = std::numeric_limits<size_t>::max(),
+                    size_t grain = default_parallel_grain) const {
+    return min_max_impl<true, false, Is...>(
+        start, end, grain, Columns::template selected_columns<Is...>());
+  }
+
+  // the number of rows where pred, called with the selected columns, is
+  // true, which for a single dictionary column reads only the codes
+  template <size_t... Is, class F>
+  size_t count_if(F &&pred, size_t start = 0,
+                  size_t end = std::numeric_limits<size_t>::max()) const {
+    if constexpr (Columns::template dictionary_column<Is...>()) {
+      return count_matching_codes<false, Is...>(pred, start, end, 0);
+    } else {
+      return reduce<Is...>(
+          size_t(0),
+          [&pred](const auto &...args) -> size_t {
+            return pred(args...) ? 1 : 0;
+          },
+          std::plus<>(), start, end);
+    }
+  }
+
+  template <size_t... Is, class F>
+  size_t parallel_count_if(F &&pred, size_t start = 0,
+                           size_t end = std::numeric_limits<size_t>::max(),
+                           size_t grain = default_parallel_grain) const {
+    if constexpr (Columns::template dictionary_column<Is...>()) {
+      return count_matching_codes<true, Is...>(pred, start, end, grain);
+    } else {
+      return parallel_reduce<Is...>(
+          size_t(0),
+          [&pred](const auto &...args) -> size_t {
+            return pred(args...) ? 1 : 0;
+          },
+          std::plus<>(), start, end, grain);
+    }
+  }
+
+  // the number of rows in [start, end) of the view with their flag in bit
+  // column I set, and any, all and find_next, all a word at a time
+  template <size_t I>
+  size_t count(size_t start = 0,
+               size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return bit_column<I>().count(offset + start, offset + end);
+  }
+
+  template <size_t I>
+  bool any(size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return bit_column<I>().any(offset + start, offset + end);
+  }
+
+  template <size_t I>
+  bool all(size_t start = 0,
+           size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return bit_column<I>().all(offset + start, offset + end);
+  }
+
+  // the first row of the view in [start, end) with its flag set, or end
+  template <size_t I>
+  size_t find_next(size_t start = 0,
+                   size_t end = std::numeric_limits<size_t>::max()) const {
+    if (end == std::numeric_limits<size_t>::max()) {
+      end = num_elements;
+    }
+    return bit_column<I>().find_next(offset + start, offset + end) - offset;
+  }
+
+  // sorts the rows of the view by the values in column K, moving only the
+  // columns of the view
+  template <size_t K, class Compare = std::less<>>
+  void sort_by(Compare comp = Compare()) const {
+    comparison_sort_by<K, false, false>(comp, 0);
+  }
+
+  template <size_t K, class Compare = std::less<>>
+  void stable_sort_by(Compare comp = Compare()) const {
+    comparison_sort_by<K, true, false>(comp, 0);
+  }
+
+  template <size_t K, class Compare = std::less<>>
+  void parallel_sort_by(Compare comp = Compare(),
+                        size_t grain = default_parallel_grain) const {
+    comparison_sort_by<K, false, true>(comp, grain);
+  }
+
+  template <size_t K, class Compare = std::less<>>
+  void parallel_stable_sort_by(Compare comp = Compare(),
+                               size_t grain = default_parallel_grain) const {
+    comparison_sort_by<K, true, true>(comp, grain);
+  }
+
+  // sorts the rows of the view by the integer column K with a radix sort
+  template <size_t K> void radix_sort_by() const {
+    radix_sort_by_impl<K, false>(0);
+  }
+
+  template <size_t K>
+  void parallel_radix_sort_by(size_t grain = default_parallel_grain) const {
+    radix_sort_by_impl<K, true>(grain);
+  }
+
+  // walks the rows of a read only view, handing out each one as read by get
+  class ConstIterator {
+    const BasicSOAView *view = nullptr;
+    size_t index = 0;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+
+    ConstIterator() = default;
+    ConstIterator(const BasicSOAView *v, size_t i) : view(v), index(i) {}
+
+    auto operator*() const { return view->get(index); }
+    ConstIterator &operator++() {
+      ++index;
+      return *this;
+    }
+    ConstIterator operator++(int) {
+      ConstIterator tmp(*this);
+      ++index;
+      return tmp;
+    }
+    bool operator==(const ConstIterator &rhs) const {
+      return index == rhs.index;
+    }
+  };
+
+  auto begin() const {
+    if constexpr (ReadOnly) {
+      return ConstIterator(this, 0);
+    } else {
+      return typename Columns::Iterator(columns, offset);
+    }
+  }
+  auto end() const {
+    if constexpr (ReadOnly) {
+      return ConstIterator(this, num_elements);
+    } else {
+      return typename Columns::Iterator(columns, offset + num_elements);
+    }
+  }
+
+private:
+  template <bool Parallel, size_t... Selected, size_t... Is>
+  auto sum_impl(size_t start, size_t end, size_t grain,
+                [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq)
+      const {
+    using R = std::common_type_t<sum_value_t<NthType<Is>>...>;
+    auto map = [](const auto &...args) { return (R(0) + ... + R(args)); };
+    if constexpr (Parallel) {
+      return parallel_reduce<Selected...>(R(0), map, std::plus<>(), start, end,
+                                          grain);
+    } else {
+      return reduce<Selected...>(R(0), map, std::plus<>(), start, end);
+    }
+  }
+
+  template <bool Parallel, bool Min, size_t... Selected, size_t... Is>
+  auto
+  min_max_impl(size_t start, size_t end, size_t grain,
+               [[maybe_unused]] std::integer_sequence<size_t, Is...> int_seq)
+      const {
+    using R = std::common_type_t<native_value_t<NthType<Is>>...>;
+    auto combine = [](R a, R b) {
+      if constexpr (Min) {
+        return std::min(a, b);
+      } else {
+        return std::max(a, b);
+      }
+    };
+    R identity = Min ? std::numeric_limits<R>::max()
+                     : std::numeric_limits<R>::lowest();
+    auto map = [&combine, identity](const auto &...args) {
+      R result = identity;
+      ((result = combine(result, R(args))), ...);
+      return result;
+    };
+    if constexpr (Parallel) {
+      return parallel_reduce<Selected...>(identity, map, combine, start, end,
+                                          grain);
+    } else {
+      return reduce<Selected...>(identity, map, combine, start, end);
+    }
+  }
 };
+
+template <typename... Ts>
+using SOA = BasicSOA<SOALayout<>, MallocAllocator, Ts...>;
@@ -1,13 +1,32 @@
 #include "StructOfArrays/aos.hpp"
+#include "StructOfArrays/aosoa.hpp"
+#include "StructOfArrays/internal/Bit.hpp"
+#include "StructOfArrays/internal/Dictionary.hpp"
+#include "StructOfArrays/internal/FrameInt.hpp"
+#include "StructOfArrays/internal/PackedInt.hpp"
 #include "StructOfArrays/internal/SizedInt.hpp"
+#include "StructOfArrays/mapped.hpp"
+#include "StructOfArrays/pma.hpp"
 #include "StructOfArrays/soa.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <fcntl.h>
 #include <limits>
+#include <linux/perf_event.h>
+#include <map>
+#include <memory_resource>
+#include <numeric>
 #include <random>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <tuple>
+#include <unistd.h>
+#include <vector>
 
 static inline uint64_t get_time() {
   struct timeval st {};
@@ -25,6 +44,1037 @@ std::ostream &operator<<(std::ostream &os, const value_and_flag &vf) {
   return os;
 }
 
+// runs the same set of map_range scans as the main benchmarks over an already
+// filled container
+template <class Container> void time_scans(Container &tup) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+
+  start = get_time();
+  size_t sum_first = 0;
+  tup.template map_range<0>([&sum_first](auto x) { sum_first += x; });
+  end = get_time();
+  std::cout << "First time was " << end - start << "  sum was " << sum_first
+            << "\n";
+
+  start = get_time();
+  size_t sum_forth = 0;
+  tup.template map_range<3>([&sum_forth](auto x) { sum_forth += x; });
+  end = get_time();
+  std::cout << "Forth time was " << end - start << "  sum was " << sum_forth
+            << "\n";
+
+  start = get_time();
+  size_t sum_second_2 = 0;
+  tup.template map_range<2, 3>(
+      [&sum_second_2](auto x, auto y) { sum_second_2 += x + y; });
+  end = get_time();
+  std::cout << "Second 2 time was " << end - start << "  sum was "
+            << sum_second_2 << "\n";
+
+  start = get_time();
+  size_t sum_all = 0;
+  tup.map_range([&sum_all](auto... args) { sum_all += (0 + ... + args); });
+  end = get_time();
+  std::cout << "All time was " << end - start << "  sum was " << sum_all
+            << "\n";
+}
+
+template <class Layout> void time_layout_scans(uint64_t number_of_elements) {
+  auto tup =
+      BasicSOA<Layout, MallocAllocator, uint8_t, uint16_t, uint32_t, uint64_t>(
+          number_of_elements);
+  std::cout << "size = " << tup.get_size() << "  column 3 starts at "
+            << reinterpret_cast<uintptr_t>(tup.template get_ptr<3>(0)) % 4096
+            << " mod 4096\n";
+  for (uint64_t i = 0; i < number_of_elements; i++) {
+    tup.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+  }
+  time_scans(tup);
+}
+
+// counts data TLB misses for the calling thread while it is in scope, if the
+// kernel lets us open the counter
+class dtlb_miss_counter {
+  int fd = -1;
+
+public:
+  dtlb_miss_counter() {
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8U) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd != -1) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+  ~dtlb_miss_counter() {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+  dtlb_miss_counter(const dtlb_miss_counter &) = delete;
+  dtlb_miss_counter &operator=(const dtlb_miss_counter &) = delete;
+
+  void print(const std::string &name) const {
+    uint64_t count = 0;
+    if (fd == -1 || read(fd, &count, sizeof(count)) != sizeof(count)) {
+      std::cout << name << " dTLB misses unavailable\n";
+      return;
+    }
+    std::cout << name << " dTLB misses were " << count << "\n";
+  }
+};
+
+template <class Allocator>
+void time_allocator(uint64_t number_of_elements, Allocator alloc = {}) {
+  auto tup = BasicSOA<SOALayout<>, Allocator, uint8_t, uint16_t, uint32_t,
+                      uint64_t>(number_of_elements, alloc);
+  for (uint64_t i = 0; i < number_of_elements; i++) {
+    tup.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+  }
+  uint64_t start = 0;
+  uint64_t end = 0;
+  {
+    dtlb_miss_counter counter;
+    start = get_time();
+    size_t sum_all = 0;
+    tup.map_range([&sum_all](auto... args) { sum_all += (0 + ... + args); });
+    end = get_time();
+    std::cout << "scan time was " << end - start << "  sum was " << sum_all
+              << "\n";
+    counter.print("scan");
+  }
+  {
+    std::mt19937_64 gen(0);
+    std::uniform_int_distribution<uint64_t> dist(0, number_of_elements - 1);
+    std::vector<uint64_t> indices(number_of_elements);
+    for (auto &index : indices) {
+      index = dist(gen);
+    }
+    dtlb_miss_counter counter;
+    start = get_time();
+    size_t sum_all = 0;
+    for (auto index : indices) {
+      sum_all += std::apply([](auto... args) { return (0 + ... + args); },
+                            tup.get(index));
+    }
+    end = get_time();
+    std::cout << "random access time was " << end - start << "  sum was "
+              << sum_all << "\n";
+    counter.print("random access");
+  }
+}
+
+// reads whole rows at random
+template <class Container>
+void time_random_rows(Container &tup, uint64_t number_of_elements) {
+  std::mt19937_64 gen(0);
+  std::uniform_int_distribution<uint64_t> dist(0, number_of_elements - 1);
+  std::vector<uint64_t> indices(number_of_elements);
+  for (auto &index : indices) {
+    index = dist(gen);
+  }
+  uint64_t start = get_time();
+  size_t sum_all = 0;
+  for (auto index : indices) {
+    sum_all += std::apply([](auto... args) { return (0 + ... + args); },
+                          tup.template get<0, 1, 2, 3>(index));
+  }
+  uint64_t end = get_time();
+  std::cout << "Random rows time was " << end - start << "  sum was "
+            << sum_all << "\n";
+}
+
+template <class Container> void time_row_matrix(uint64_t number_of_elements) {
+  auto tup = Container(number_of_elements);
+  for (uint64_t i = 0; i < number_of_elements; i++) {
+    tup.template get<0, 1, 2, 3>(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+  }
+  time_scans(tup);
+  time_random_rows(tup, number_of_elements);
+}
+
+// the scans from the main benchmarks, changed to update each element so that
+// they can run in parallel
+template <class Container> void time_parallel_scans(Container &tup) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+
+  start = get_time();
+  tup.template parallel_map_range<0>([](auto &x) { x += 1; });
+  end = get_time();
+  std::cout << "First time was " << end - start << "\n";
+
+  start = get_time();
+  tup.template parallel_map_range<3>([](auto &x) { x += 1; });
+  end = get_time();
+  std::cout << "Forth time was " << end - start << "\n";
+
+  start = get_time();
+  tup.template parallel_map_range<2, 3>([](auto &x, auto &y) { x += y; });
+  end = get_time();
+  std::cout << "Second 2 time was " << end - start << "\n";
+
+  start = get_time();
+  tup.parallel_map_range([](auto &...args) { ((args += 1), ...); });
+  end = get_time();
+  std::cout << "All time was " << end - start << "\n";
+
+  start = get_time();
+  tup.template parallel_map_range_with_index<3>(
+      [](size_t i, auto &x) { x = 4 * i; });
+  end = get_time();
+  std::cout << "With index time was " << end - start << "\n";
+}
+
+// column sums through an external accumulator in map_range compared with
+// the reduce based sum
+template <class Container> void time_reductions(Container &tup) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+
+  start = get_time();
+  size_t sum_forth = 0;
+  tup.template map_range<3>([&sum_forth](auto x) { sum_forth += x; });
+  end = get_time();
+  std::cout << "map_range sum time was " << end - start << "  sum was "
+            << sum_forth << "\n";
+
+  start = get_time();
+  sum_forth = tup.template sum<3>();
+  end = get_time();
+  std::cout << "sum time was " << end - start << "  sum was " << sum_forth
+            << "\n";
+
+  start = get_time();
+  sum_forth = tup.template parallel_sum<3>();
+  end = get_time();
+  std::cout << "parallel sum time was " << end - start << "  sum was "
+            << sum_forth << "\n";
+
+  start = get_time();
+  size_t sum_all = tup.sum();
+  end = get_time();
+  std::cout << "sum all time was " << end - start << "  sum was " << sum_all
+            << "\n";
+
+  start = get_time();
+  auto min_forth = tup.template min<3>();
+  auto max_forth = tup.template max<3>();
+  end = get_time();
+  std::cout << "min and max time was " << end - start << "  min was "
+            << min_forth << " max was " << max_forth << "\n";
+
+  start = get_time();
+  size_t count = tup.template count_if<0, 1>(
+      [](auto x, auto y) { return (x & 1U) == 0 && y > 1000; });
+  end = get_time();
+  std::cout << "count_if time was " << end - start << "  count was " << count
+            << "\n";
+}
+
+template <size_t I, class Container> void time_simd_sum(Container &tup) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+
+  start = get_time();
+  uint64_t sum = 0;
+  tup.template map_range<I>([&sum](auto x) { sum += x; });
+  end = get_time();
+  std::cout << "column " << I << " map_range sum time was " << end - start
+            << "  sum was " << sum << "\n";
+
+  // the batches of a narrow column have more lanes than a register of
+  // uint64_t holds, so each is widened a register at a time
+  constexpr size_t lanes = Container::template simd_lanes<I>();
+  constexpr size_t sum_lanes = simd_lanes_for<uint64_t>;
+  start = get_time();
+  simd_batch<uint64_t, sum_lanes> sums;
+  tup.template map_range_simd<I>([&sums](auto x) {
+    typename decltype(x)::value_type values[lanes];
+    std::memcpy(values, &x.v, sizeof(values));
+    for (size_t lane = 0; lane < lanes; lane += sum_lanes) {
+      sums += simd_batch<uint64_t, sum_lanes>::load(values + lane);
+    }
+  });
+  sum = sums.reduce_add();
+  end = get_time();
+  std::cout << "column " << I << " map_range_simd sum time was "
+            << end - start << "  sum was " << sum << "\n";
+}
+
+template <class Container> void time_simd_scans(Container &tup) {
+  time_simd_sum<0>(tup);
+  time_simd_sum<2>(tup);
+  time_simd_sum<3>(tup);
+
+  uint64_t start = 0;
+  uint64_t end = 0;
+
+  start = get_time();
+  uint64_t dot = 0;
+  tup.template map_range<0, 3>([&dot](auto x, auto y) { dot += x * y; });
+  end = get_time();
+  std::cout << "map_range dot product time was " << end - start
+            << "  result was " << dot << "\n";
+
+  constexpr size_t lanes = Container::template simd_lanes<0, 3>();
+  start = get_time();
+  simd_batch<uint64_t, lanes> dots;
+  tup.template map_range_simd<0, 3>([&dots](auto x, auto y) {
+    dots += x.template convert<uint64_t>() * y.template convert<uint64_t>();
+  });
+  dot = dots.reduce_add();
+  end = get_time();
+  std::cout << "map_range_simd dot product time was " << end - start
+            << "  result was " << dot << "\n";
+}
+
+// std algorithms over a column span compared with the same loop written over
+// the raw column pointer
+template <class Container> void time_column_spans(Container &tup) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+  auto forth = tup.template column<3>();
+
+  start = get_time();
+  uint64_t sum = 0;
+  const uint64_t *raw = tup.template get_ptr<3>(0);
+  for (size_t i = 0; i < tup.size(); i++) {
+    sum += raw[i];
+  }
+  end = get_time();
+  std::cout << "raw loop sum time was " << end - start << "  sum was " << sum
+            << "\n";
+
+  start = get_time();
+  sum = std::accumulate(forth.begin(), forth.end(), uint64_t(0));
+  end = get_time();
+  std::cout << "span accumulate time was " << end - start << "  sum was "
+            << sum << "\n";
+
+  auto [third, out] = tup.template columns<2, 3>();
+
+  start = get_time();
+  const uint32_t *raw_third = tup.template get_ptr<2>(0);
+  uint64_t *raw_out = tup.template get_ptr<3>(0);
+  for (size_t i = 0; i < tup.size(); i++) {
+    raw_out[i] = raw_third[i] * 3 + 1;
+  }
+  end = get_time();
+  std::cout << "raw loop transform time was " << end - start << "  last was "
+            << out.back() << "\n";
+
+  start = get_time();
+  std::transform(third.begin(), third.end(), out.begin(),
+                 [](uint32_t x) -> uint64_t { return x * 3 + 1; });
+  end = get_time();
+  std::cout << "span transform time was " << end - start << "  last was "
+            << out.back() << "\n";
+}
+
+// random reads through get, which uses the cached column starts, compared
+// with get_static, which works out the column offsets on every call
+template <class Container>
+void time_random_access(Container &tup, const std::vector<uint64_t> &indices) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+
+  start = get_time();
+  uint64_t sum = 0;
+  for (auto i : indices) {
+    sum += std::apply([](auto... args) { return (0 + ... + args); },
+                      tup.get(i));
+  }
+  end = get_time();
+  std::cout << "random get time was " << end - start << "  sum was " << sum
+            << "\n";
+
+  start = get_time();
+  sum = 0;
+  void *base_array = tup.get_ptr(0).get_pointer();
+  for (auto i : indices) {
+    sum += std::apply([](auto... args) { return (0 + ... + args); },
+                      Container::get_static(base_array, tup.capacity(), i));
+  }
+  end = get_time();
+  std::cout << "random get_static time was " << end - start << "  sum was "
+            << sum << "\n";
+
+  start = get_time();
+  std::sort(tup.begin(), tup.end());
+  end = get_time();
+  std::cout << "iterator sort time was " << end - start << "\n";
+}
+
+// sorting by one key column through the iterator compared with sort_by,
+// which sorts the keys alone and then gathers each column once
+template <size_t K, class Container>
+void time_sort_by(Container &tup, const Container &original) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+  auto restore = [&]() {
+    for (size_t i = 0; i < original.size(); i++) {
+      tup.get(i) = original.get(i);
+    }
+  };
+  auto check = [&]() {
+    auto keys = tup.template column<K>();
+    return std::is_sorted(keys.begin(), keys.end()) ? "sorted" : "NOT sorted";
+  };
+
+  restore();
+  start = get_time();
+  std::sort(tup.begin(), tup.end(), [](auto lhs, auto rhs) {
+    return std::get<K>(typename Container::T(lhs)) <
+           std::get<K>(typename Container::T(rhs));
+  });
+  end = get_time();
+  std::cout << "iterator sort by column " << K << " time was " << end - start
+            << "  " << check() << "\n";
+
+  restore();
+  start = get_time();
+  tup.template sort_by<K>();
+  end = get_time();
+  std::cout << "sort_by time was " << end - start << "  " << check() << "\n";
+
+  restore();
+  start = get_time();
+  tup.template stable_sort_by<K>();
+  end = get_time();
+  std::cout << "stable_sort_by time was " << end - start << "  " << check()
+            << "\n";
+
+  restore();
+  start = get_time();
+  tup.template parallel_sort_by<K>();
+  end = get_time();
+  std::cout << "parallel_sort_by time was " << end - start << "  " << check()
+            << "\n";
+
+  restore();
+  start = get_time();
+  tup.template parallel_stable_sort_by<K>();
+  end = get_time();
+  std::cout << "parallel_stable_sort_by time was " << end - start << "  "
+            << check() << "\n";
+}
+
+// the comparison based sort_by compared with the radix sort on the same key
+template <size_t K, class Container>
+void time_radix_sort_by(Container &tup, const Container &original) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+  auto restore = [&]() {
+    for (size_t i = 0; i < original.size(); i++) {
+      tup.get(i) = original.get(i);
+    }
+  };
+  auto check = [&]() {
+    auto keys = tup.template column<K>();
+    return std::is_sorted(keys.begin(), keys.end(),
+                          [](auto a, auto b) { return +a < +b; })
+               ? "sorted"
+               : "NOT sorted";
+  };
+
+  restore();
+  start = get_time();
+  tup.template stable_sort_by<K>();
+  end = get_time();
+  std::cout << "stable_sort_by column " << K << " time was " << end - start
+            << "  " << check() << "\n";
+
+  restore();
+  start = get_time();
+  tup.template radix_sort_by<K>();
+  end = get_time();
+  std::cout << "radix_sort_by time was " << end - start << "  " << check()
+            << "\n";
+
+  restore();
+  start = get_time();
+  tup.template parallel_stable_sort_by<K>();
+  end = get_time();
+  std::cout << "parallel_stable_sort_by time was " << end - start << "  "
+            << check() << "\n";
+
+  restore();
+  start = get_time();
+  tup.template parallel_radix_sort_by<K>();
+  end = get_time();
+  std::cout << "parallel_radix_sort_by time was " << end - start << "  "
+            << check() << "\n";
+}
+
+// dropping the rows whose first column is below threshold, by rebuilding the
+// container one row at a time compared with the column wise erase_if
+template <class Container>
+void time_erase_if(const Container &original, uint64_t threshold) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+  auto drop = [threshold](auto x) { return x < threshold; };
+
+  start = get_time();
+  Container rebuilt;
+  original.map_range([&](auto... args) {
+    if (!drop(std::get<0>(std::forward_as_tuple(args...)))) {
+      rebuilt.emplace_back(args...);
+    }
+  });
+  end = get_time();
+  std::cout << "push_back rebuild time was " << end - start << "  kept "
+            << rebuilt.size() << "\n";
+
+  Container tup(original.size());
+  auto restore = [&]() {
+    tup.clear();
+    tup.append(original);
+  };
+
+  restore();
+  start = get_time();
+  tup.template erase_if<0>(drop);
+  end = get_time();
+  std::cout << "erase_if time was " << end - start << "  kept " << tup.size()
+            << "\n";
+
+  restore();
+  start = get_time();
+  tup.template parallel_erase_if<0>(drop);
+  end = get_time();
+  std::cout << "parallel_erase_if time was " << end - start << "  kept "
+            << tup.size() << "\n";
+
+  Container filtered;
+  start = get_time();
+  original.template filter_into<0>(filtered, [&](auto x) { return !drop(x); });
+  end = get_time();
+  std::cout << "filter_into time was " << end - start << "  kept "
+            << filtered.size() << "\n";
+
+  restore();
+  start = get_time();
+  size_t kept = tup.template partition<0>([&](auto x) { return !drop(x); });
+  end = get_time();
+  std::cout << "partition time was " << end - start << "  kept " << kept
+            << "\n";
+}
+
+// random row lookups one get at a time compared with the prefetching gather,
+// for SOA and AOS
+template <class SOAContainer, class AOSContainer>
+void time_gathers(SOAContainer &soa, AOSContainer &aos,
+                  const std::vector<uint64_t> &indices) {
+  uint64_t start = 0;
+  uint64_t end = 0;
+  std::vector<uint64_t> first(indices.size());
+  std::vector<uint32_t> third(indices.size());
+  auto checksum = [&]() {
+    return std::accumulate(first.begin(), first.end(), uint64_t(0)) +
+           std::accumulate(third.begin(), third.end(), uint64_t(0));
+  };
+
+  start = get_time();
+  for (size_t j = 0; j < indices.size(); j++) {
+    std::tie(first[j], third[j]) = soa.template get<3, 2>(indices[j]);
+  }
+  end = get_time();
+  std::cout << "SOA get loop time was " << end - start << "  checksum was "
+            << checksum() << "\n";
+
+  start = get_time();
+  soa.template gather<3, 2>(indices, first.data(), third.data());
+  end = get_time();
+  std::cout << "SOA gather time was " << end - start << "  checksum was "
+            << checksum() << "\n";
+
+  start = get_time();
+  typename SOAContainer::template Projection<3, 2> out;
+  soa.template gather<3, 2>(indices, out);
+  end = get_time();
+  std::cout << "SOA gather into SOA time was " << end - start
+            << "  checksum was " << out.sum() << "\n";
+
+  start = get_time();
+  for (size_t j = 0; j < indices.size(); j++) {
+    std::tie(first[j], third[j]) = aos.template get<3, 2>(indices[j]);
+  }
+  end = get_time();
+  std::cout << "AOS get loop time was " << end - start << "  checksum was "
+            << checksum() << "\n";
+
+  start = get_time();
+  aos.template gather<3, 2>(indices, first.data(), third.data());
+  end = get_time();
+  std::cout << "AOS gather time was " << end - start << "  checksum was "
+            << checksum() << "\n";
+
+  start = get_time();
+  soa.template gather<3, 2>(indices, first.data(), third.data());
+  soa.template scatter<3, 2>(indices, first.data(), third.data());
+  end = get_time();
+  std::cout << "SOA gather and scatter back time was " << end - start << "\n";
+}
+
+// times loading the selected columns of a saved file and prints the
+// bandwidth, with cold first evicting the file from the page cache
+template <class SOAContainer, size_t... Is>
+void time_load(const char *path, bool cold) {
+  if (cold) {
+    int fd = open(path, O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+  typename SOAContainer::template Projection<Is...> out;
+  uint64_t start = get_time();
+  if (!SOAContainer::template load<Is...>(path, out)) {
+    std::cout << "load failed\n";
+    return;
+  }
+  uint64_t end = get_time();
+  size_t bytes = out.size() * sizeof(typename decltype(out)::T);
+  std::cout << (cold ? "cold" : "page cache") << " load of "
+            << std::tuple_size_v<typename decltype(out)::T>
+            << " columns time was " << end - start << "  bandwidth was "
+            << bytes / std::max(end - start, uint64_t(1)) << " MB/s  sum was "
+            << out.sum() << "\n";
+}
+
+// times a map_range over column I alone and prints its sum
+template <size_t I, class Container>
+void time_column_scan(Container &tup, const char *label) {
+  uint64_t start = get_time();
+  size_t sum = 0;
+  tup.template map_range<I>([&sum](auto x) { sum += x; });
+  uint64_t end = get_time();
+  std::cout << label << " time was " << end - start << "  sum was " << sum
+            << "\n";
+}
+
+// scans each column of a four column SOA on its own and then all together,
+// to compare packed widths against the native types
+template <class SOAContainer>
+void time_width_scans(const char *name, uint64_t number_of_elements) {
+  std::cout << "\n" << name << "\n";
+  auto tup = SOAContainer(number_of_elements);
+  std::cout << "size = " << tup.get_size() << "\n";
+  for (uint64_t i = 0; i < number_of_elements; i++) {
+    tup.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+  }
+  time_column_scan<0>(tup, "First");
+  time_column_scan<1>(tup, "Second");
+  time_column_scan<2>(tup, "Third");
+  time_column_scan<3>(tup, "Forth");
+
+  uint64_t start = get_time();
+  size_t sum_all = 0;
+  tup.map_range([&sum_all](auto... args) { sum_all += (0 + ... + args); });
+  uint64_t end = get_time();
+  std::cout << "All time was " << end - start << "  sum was " << sum_all
+            << "\n";
+
+  start = get_time();
+  uint64_t sum = tup.sum();
+  end = get_time();
+  std::cout << "sum() time was " << end - start << "  sum was " << sum << "\n";
+}
+
+// times fill, writing two columns element by element, and assign from native
+// arrays, fill goes first so that none of the others pay for the page faults
+template <class SOAContainer>
+void time_bulk_writes(const char *name, uint64_t number_of_elements) {
+  std::cout << "\nbulk writes for " << name << "\n";
+  auto tup = SOAContainer(number_of_elements);
+  std::vector<uint32_t> first(number_of_elements);
+  std::vector<uint64_t> second(number_of_elements);
+  for (uint64_t i = 0; i < number_of_elements; i++) {
+    first[i] = i;
+    second[i] = 2 * i;
+  }
+
+  uint64_t start = get_time();
+  tup.template fill<0>(1);
+  tup.template fill<1>(2);
+  uint64_t end = get_time();
+  std::cout << "fill time was " << end - start << "  sum was "
+            << tup.template sum<0, 1>() << "\n";
+
+  start = get_time();
+  for (uint64_t i = 0; i < number_of_elements; i++) {
+    tup.template get<0, 1>(i) = std::make_tuple(first[i], second[i]);
+  }
+  end = get_time();
+  std::cout << "get loop time was " << end - start << "  sum was "
+            << tup.template sum<0, 1>() << "\n";
+
+  start = get_time();
+  tup.template assign<0>(first.data());
+  tup.template assign<1>(second.data());
+  end = get_time();
+  std::cout << "assign time was " << end - start << "  sum was "
+            << tup.template sum<0, 1>() << "\n";
+}
+
+// times scanning and randomly reading a single column SOA of timestamps,
+// which grow by a small random step from one to the next, and prints how many
+// times smaller than a plain uint64_t column it is
+template <class SOAContainer>
+void time_timestamp_column(const char *name,
+                           const std::vector<uint64_t> &timestamps,
+                           const std::vector<uint64_t> &indices) {
+  size_t n = timestamps.size();
+  auto tup = SOAContainer(n);
+  if (!tup.template assign<0>(timestamps.data())) {
+    std::cout << name << " could not hold the timestamps\n";
+    return;
+  }
+  double bytes_per_element = double(tup.get_size()) / double(n);
+  std::cout << name << "  bytes per element " << bytes_per_element
+            << "  compression ratio " << sizeof(uint64_t) / bytes_per_element
+            << "\n";
+
+  uint64_t start = get_time();
+  uint64_t sum = 0;
+  tup.map_range([&sum](auto x) { sum += x; });
+  uint64_t end = get_time();
+  std::cout << "map_range time was " << end - start << "  sum was " << sum
+            << "\n";
+
+  start = get_time();
+  sum = tup.sum();
+  end = get_time();
+  std::cout << "sum() time was " << end - start << "  sum was " << sum << "\n";
+
+  start = get_time();
+  sum = 0;
+  for (uint64_t i : indices) {
+    sum += std::get<0>(tup.get(i));
+  }
+  end = get_time();
+  std::cout << "random get time was " << end - start << "  sum was " << sum
+            << "\n";
+
+  // rows appended after clear are framed on their own, not together with the
+  // rows that were cleared
+  auto small = SOAContainer(5);
+  small.template fill<0>(3);
+  tup.clear();
+  bool appended = tup.append(small);
+  std::cout << "after clear and append " << (appended ? "" : "not ")
+            << "appended, sum was " << tup.sum() << "\n";
+}
+
+// times an equality count, an IN list count and a count by value over a
+// status code column and a region column filled with values drawn from small
+// sets
+template <class SOAContainer, bool Dictionary>
+void time_low_cardinality(const char *name, uint64_t number_of_elements) {
+  std::cout << name << "\n";
+  std::mt19937 g(0);
+  std::array<uint32_t, 7> statuses = {200, 201, 301, 304, 404, 500, 503};
+  std::uniform_int_distribution<uint32_t> status(0, statuses.size() - 1);
+  std::uniform_int_distribution<uint16_t> region(1, 40);
+  auto tup = SOAContainer(number_of_elements);
+  uint64_t start = get_time();
+  for (uint64_t i = 0; i < number_of_elements; i++) {
+    tup.get(i) = std::make_tuple(statuses[status(g)], region(g));
+  }
+  uint64_t end = get_time();
+  std::cout << "bytes per element "
+            << double(tup.get_size()) / number_of_elements
+            << "  fill time was " << end - start << "\n";
+
+  start = get_time();
+  size_t count = tup.template count_if<0>([](auto x) { return x == 404; });
+  end = get_time();
+  std::cout << "equality count time was " << end - start << "  count was "
+            << count << "\n";
+
+  start = get_time();
+  count = tup.template count_if<0>(
+      [](auto x) { return x == 500 || x == 503 || x == 404; });
+  end = get_time();
+  std::cout << "IN list count time was " << end - start << "  count was "
+            << count << "\n";
+
+  start = get_time();
+  std::vector<size_t> by_region(65536);
+  if constexpr (Dictionary) {
+    for (auto [value, n] : tup.template value_counts<1>()) {
+      by_region[value] = n;
+    }
+  } else {
+    tup.template map_range<1>([&by_region](auto x) { by_region[x] += 1; });
+  }
+  end = get_time();
+  std::cout << "count by region time was " << end - start
+            << "  count of region 7 was " << by_region[7] << "\n";
+}
+
+// times counting the set flags and summing the values of only the flagged
+// rows, where one row in one_in is flagged
+template <class SOAContainer, bool Bitmap>
+void time_flag_column(const char *name, uint64_t number_of_elements,
+                      uint64_t one_in) {
+  std::cout << name << " with one row in " << one_in << " flagged\n";
+  std::mt19937 g(0);
+  std::uniform_int_distribution<uint64_t> flagged(0, one_in - 1);
+  auto tup = SOAContainer(number_of_elements);
+  for (uint64_t i = 0; i < number_of_elements; i++) {
+    tup.get(i) = std::make_tuple(i, flagged(g) == 0);
+  }
+  std::cout << "bytes per element "
+            << double(tup.get_size()) / number_of_elements << "\n";
+
+  uint64_t start = get_time();
+  size_t count = 0;
+  if constexpr (Bitmap) {
+    count = tup.template count<1>();
+  } else {
+    count = tup.template count_if<1>([](bool flag) { return flag; });
+  }
+  uint64_t end = get_time();
+  std::cout << "count time was " << end - start << "  count was " << count
+            << "\n";
+
+  start = get_time();
+  uint64_t sum = 0;
+  if constexpr (Bitmap) {
+    tup.template map_range_where<1, 0>([&sum](uint64_t x) { sum += x; });
+  } else {
+    tup.template map_range<0, 1>([&sum](uint64_t x, bool flag) {
+      if (flag) {
+        sum += x;
+      }
+    });
+  }
+  end = get_time();
+  std::cout << "flagged sum time was " << end - start << "  sum was " << sum
+            << "\n";
+}
+
+// times reading 2 of 8 columns through a copy made by pull_types and
+// through a view of the same columns
+void time_projection(uint64_t number_of_elements) {
+  using Table = SOA<uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t,
+                    uint64_t, uint64_t>;
+  auto tup = Table(number_of_elements);
+  tup.map_range_with_index([](uint64_t i, auto &...columns) {
+    ((columns = i), ...);
+  });
+
+  uint64_t start = get_time();
+  auto copy = tup.pull_types<1, 5>();
+  uint64_t projected = get_time();
+  uint64_t sum = copy.sum();
+  uint64_t end = get_time();
+  std::cout << "pull_types<1, 5> took " << projected - start
+            << " then sum took " << end - projected << "  sum was " << sum
+            << "\n";
+
+  start = get_time();
+  auto view = tup.view<1, 5>();
+  projected = get_time();
+  sum = view.sum();
+  end = get_time();
+  std::cout << "view<1, 5> took " << projected - start << " then sum took "
+            << end - projected << "  sum was " << sum << "\n";
+}
+
+// moves, swaps, clones and hands off the block of an SOA through every path,
+// build with SANITIZE=1 to have each of them checked for leaks and double
+// frees
+template <class SOAContainer> void check_ownership(uint64_t n) {
+  auto fill = [](SOAContainer &tup, uint64_t start) {
+    for (uint64_t i = 0; i < tup.size(); i++) {
+      tup.get(i) = std::make_tuple(start + i, start + i, (start + i) % 2);
+    }
+  };
+  auto tup = SOAContainer(n);
+  fill(tup, 0);
+  std::cout << "original sum " << tup.sum() << "\n";
+
+  auto moved = std::move(tup);
+  std::cout << "moved sum " << moved.sum() << "  moved from size "
+            << tup.size() << "\n";
+
+  auto other = SOAContainer(n / 2);
+  fill(other, 1);
+  other = std::move(moved);
+  std::cout << "move assigned sum " << other.sum() << "  moved from size "
+            << moved.size() << "\n";
+  auto &same = other;
+  other = std::move(same);
+  std::cout << "self move assigned sum " << other.sum() << "\n";
+
+  auto copy = other.clone();
+  fill(copy, 1);
+  std::cout << "clone sum " << copy.sum() << "  original sum " << other.sum()
+            << "\n";
+
+  swap(copy, other);
+  std::cout << "after swap " << copy.sum() << " " << other.sum() << "\n";
+
+  size_t capacity = copy.capacity();
+  size_t size = copy.size();
+  void *block = copy.release();
+  std::cout << "released, size is now " << copy.size() << "\n";
+  other.adopt(block, capacity, size);
+  std::cout << "adopted sum " << other.sum() << "\n";
+
+  other.push_back(other.get(0));
+  auto resized = other.resize(n / 3);
+  auto projected = other.template pull_types<0>();
+  std::cout << "resized sum " << resized.sum() << "  projected sum "
+            << projected.sum() << "\n";
+
+  std::vector<SOAContainer> tables;
+  for (uint64_t i = 0; i < 10; i++) {
+    tables.push_back(other.clone());
+  }
+  tables.erase(tables.begin());
+  std::cout << "tables " << tables.size() << " sum of last "
+            << tables.back().sum() << "\n";
+}
+
+// times batches of rows inserted into and then erased from the middle of a
+// sorted table, moving the rows after them one tuple at a time and with insert
+// and erase
+template <bool Bulk>
+void time_mid_table_updates(uint64_t number_of_elements, uint64_t batches,
+                            uint64_t batch_size) {
+  using Row = std::tuple<uint64_t, uint32_t, uint32_t, double>;
+  auto tup = SOA<uint64_t, uint32_t, uint32_t, double>(number_of_elements);
+  tup.map_range_with_index([](uint64_t i, uint64_t &key, uint32_t &a,
+                              uint32_t &b, double &c) {
+    key = 2 * i;
+    a = i;
+    b = i * 3;
+    c = i * 0.5;
+  });
+  std::mt19937 g(0);
+  std::vector<Row> batch(batch_size);
+
+  uint64_t start = get_time();
+  for (uint64_t k = 0; k < batches; k++) {
+    size_t pos = g() % tup.size();
+    for (uint64_t j = 0; j < batch_size; j++) {
+      batch[j] = {k, j, j, k * 0.25};
+    }
+    if constexpr (Bulk) {
+      tup.insert_range(pos, batch);
+    } else {
+      for (uint64_t j = 0; j < batch_size; j++) {
+        tup.push_back(Row());
+      }
+      for (uint64_t i = tup.size() - 1; i >= pos + batch_size; i--) {
+        tup.get(i) = tup.get(i - batch_size);
+      }
+      for (uint64_t j = 0; j < batch_size; j++) {
+        tup.get(pos + j) = batch[j];
+      }
+    }
+  }
+  uint64_t inserted = get_time();
+  for (uint64_t k = 0; k < batches; k++) {
+    size_t pos = g() % (tup.size() - batch_size);
+    if constexpr (Bulk) {
+      tup.erase(pos, pos + batch_size);
+    } else {
+      for (uint64_t i = pos; i + batch_size < tup.size(); i++) {
+        tup.get(i) = tup.get(i + batch_size);
+      }
+      tup.erase(tup.size() - batch_size, tup.size());
+    }
+  }
+  uint64_t end = get_time();
+  std::cout << (Bulk ? "insert and erase" : "row by row") << ": inserts took "
+            << inserted - start << " erases took " << end - inserted
+            << "  sum was " << tup.sum<0, 1, 2>() << "\n";
+}
+
+// inserts keys in random order into a table kept sorted by key, then sums a
+// column in key order and looks every key up again
+void time_ordered_inserts(uint64_t number_of_elements) {
+  std::mt19937_64 g(0);
+  std::vector<uint64_t> keys(number_of_elements);
+  for (auto &key : keys) {
+    key = g();
+  }
+
+  auto sorted = SOA<uint64_t, uint64_t>();
+  uint64_t start = get_time();
+  for (uint64_t key : keys) {
+    auto column = sorted.column<0>();
+    size_t pos = std::lower_bound(column.begin(), column.end(), key) -
+                 column.begin();
+    sorted.insert(pos, std::make_tuple(key, key / 2));
+  }
+  uint64_t inserted = get_time();
+  uint64_t sum = sorted.sum<1>();
+  uint64_t scanned = get_time();
+  uint64_t found = 0;
+  for (uint64_t key : keys) {
+    auto column = sorted.column<0>();
+    found += std::binary_search(column.begin(), column.end(), key);
+  }
+  uint64_t end = get_time();
+  std::cout << "sorted SOA: inserts took " << inserted - start
+            << " scan took " << scanned - inserted << " lookups took "
+            << end - scanned << "  sum was " << sum << " found " << found
+            << "\n";
+
+  auto pma = PMA<uint64_t, uint64_t>();
+  start = get_time();
+  for (uint64_t key : keys) {
+    pma.insert(key, key / 2);
+  }
+  inserted = get_time();
+  sum = 0;
+  pma.map_range<1>([&sum](uint64_t value) { sum += value; });
+  scanned = get_time();
+  found = 0;
+  for (uint64_t key : keys) {
+    found += pma.contains(key);
+  }
+  end = get_time();
+  std::cout << "PMA: inserts took " << inserted - start << " scan took "
+            << scanned - inserted << " lookups took " << end - scanned
+            << "  sum was " << sum << " found " << found << " in "
+            << pma.capacity() << " slots\n";
+
+  auto map = std::map<uint64_t, uint64_t>();
+  start = get_time();
+  for (uint64_t key : keys) {
+    map.emplace(key, key / 2);
+  }
+  inserted = get_time();
+  sum = 0;
+  for (const auto &[key, value] : map) {
+    sum += value;
+  }
+  scanned = get_time();
+  found = 0;
+  for (uint64_t key : keys) {
+    found += map.contains(key);
+  }
+  end = get_time();
+  std::cout << "std::map: inserts took " << inserted - start << " scan took "
+            << scanned - inserted << " lookups took " << end - scanned
+            << "  sum was " << sum << " found " << found << "\n";
+}
+
 int main(int32_t argc, char *argv[]) {
   {
     SOA<int>::print_type_details();
@@ -115,11 +1165,9 @@ int main(int32_t argc, char *argv[]) {
     tup6.map_range([&sum_all](auto... args) { sum_all += (0 + ... + args); });
     std::cout << "sum_all = " << sum_all << "\n";
 
-    for (uint64_t i = 4 - 1; i > 0; i--) {
-      tup6.get(i) = tup6.get(i - 1);
-    }
-    tup6.get(0) = std::tuple<sized_uint<3>, sized_uint<5>, sized_uint<6>,
-                             sized_uint<7>>();
+    tup6.erase(3, 4);
+    tup6.insert(0, std::tuple<sized_uint<3>, sized_uint<5>, sized_uint<6>,
+                              sized_uint<7>>());
 
     tup6.print_soa();
 
@@ -129,6 +1177,36 @@ int main(int32_t argc, char *argv[]) {
                      sized_uint<7>>();
     });
     tup6.print_soa();
+
+    auto tup7 = SOA<int, short, bool, long>();
+    for (int i = 0; i < 20; i++) {
+      tup7.push_back({i, -i, i % 2 == 0, 10L * i});
+    }
+    tup7.emplace_back(100, 200, true, 300L);
+    std::cout << "size = " << tup7.size() << " capacity = " << tup7.capacity()
+              << "\n";
+    tup7.append(tup);
+    std::vector<std::tuple<int, short, bool, long>> more = {{1, 2, false, 3},
+                                                            {4, 5, true, 6}};
+    tup7.append(more);
+    tup7.shrink_to_fit();
+    std::cout << "size = " << tup7.size() << " capacity = " << tup7.capacity()
+              << "\n";
+    tup7.print_aos_with_index();
+
+    auto tup8 = AOSOA<4, int, short, bool, long>(10);
+    tup8.print_type_details();
+    tup8.zero();
+    for (int i = 0; i < 10; i++) {
+      tup8.get(i) = std::make_tuple(10 - i, i, i % 3 == 0, 100L * i);
+    }
+    tup8.map_range<0, 1>([](auto &x, auto &y) {
+      x += 1;
+      y -= 1;
+    });
+    tup8.print_soa();
+    std::sort(tup8.begin(), tup8.end());
+    tup8.print_aos_with_index();
   }
   uint64_t flag = 0xFFFFFFFF;
   if (argc > 2) {
@@ -276,6 +1354,14 @@ int main(int32_t argc, char *argv[]) {
     std::cout << sum_all << "\n";
   }
 
+  if (argc > 1 && (flag & 2)) {
+    time_width_scans<
+        SOA<packed_uint<7>, packed_uint<11>, packed_uint<17>, packed_uint<37>>>(
+        "SOA<packed_uint<7>, packed_uint<11>, packed_uint<17>, "
+        "packed_uint<37>>",
+        std::strtol(argv[1], nullptr, 10));
+  }
+
   if (argc > 1 && (flag & 4)) {
     std::cout << "\nAOS<uint8_t, uint16_t, uint32_t, uint64_t>\n";
     uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
@@ -418,5 +1504,612 @@ int main(int32_t argc, char *argv[]) {
     std::cout << sum_all << "\n";
   }
 
+  if (argc > 1 && (flag & 8)) {
+    time_width_scans<SOA<packed_uint<24>, packed_uint<40>, packed_uint<48>,
+                         packed_uint<56>>>(
+        "SOA<packed_uint<24>, packed_uint<40>, packed_uint<48>, "
+        "packed_uint<56>>",
+        std::strtol(argv[1], nullptr, 10));
+    time_width_scans<SOA<uint32_t, uint64_t, uint64_t, uint64_t>>(
+        "SOA<uint32_t, uint64_t, uint64_t, uint64_t>",
+        std::strtol(argv[1], nullptr, 10));
+    time_bulk_writes<SOA<sized_uint<3>, sized_uint<5>>>(
+        "SOA<sized_uint<3>, sized_uint<5>>", std::strtol(argv[1], nullptr, 10));
+    time_bulk_writes<SOA<uint32_t, uint64_t>>(
+        "SOA<uint32_t, uint64_t>", std::strtol(argv[1], nullptr, 10));
+  }
+
+  if (argc > 1 && (flag & 16)) {
+    std::cout << "\nappend throughput for <uint8_t, uint16_t, uint32_t, "
+                 "uint64_t>\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    uint64_t start = 0;
+    uint64_t end = 0;
+
+    {
+      start = get_time();
+      auto tup = SOA<uint8_t, uint16_t, uint32_t, uint64_t>();
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        tup.push_back({i, 2 * i, 3 * i, 4 * i});
+      }
+      end = get_time();
+      std::cout << "SOA push_back time was " << end - start
+                << "  capacity was " << tup.capacity() << "\n";
+    }
+    {
+      start = get_time();
+      auto tup = SOA<uint8_t, uint16_t, uint32_t, uint64_t>();
+      tup.reserve(number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        tup.emplace_back(i, 2 * i, 3 * i, 4 * i);
+      }
+      end = get_time();
+      std::cout << "SOA reserved emplace_back time was " << end - start << "\n";
+    }
+    {
+      // ingest in batches of 1 << 16 rows, one bulk copy per column per batch
+      uint64_t batch_size = std::min(number_of_elements, uint64_t(1) << 16U);
+      auto batch = SOA<uint8_t, uint16_t, uint32_t, uint64_t>(batch_size);
+      for (uint64_t i = 0; i < batch_size; i++) {
+        batch.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+      }
+      start = get_time();
+      auto tup = SOA<uint8_t, uint16_t, uint32_t, uint64_t>();
+      for (uint64_t i = 0; i < number_of_elements; i += batch_size) {
+        tup.append(batch);
+      }
+      end = get_time();
+      std::cout << "SOA batched append time was " << end - start << "\n";
+    }
+    {
+      start = get_time();
+      std::vector<std::tuple<uint8_t, uint16_t, uint32_t, uint64_t>> tup;
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        tup.emplace_back(i, 2 * i, 3 * i, 4 * i);
+      }
+      end = get_time();
+      std::cout << "std::vector<std::tuple> emplace_back time was "
+                << end - start << "\n";
+    }
+    {
+      start = get_time();
+      auto tup = AOS<uint8_t, uint16_t, uint32_t, uint64_t>();
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        tup.push_back({i, 2 * i, 3 * i, 4 * i});
+      }
+      end = get_time();
+      std::cout << "AOS push_back time was " << end - start << "\n";
+    }
+  }
+
+  if (argc > 1 && (flag & 32)) {
+    std::cout << "\nresize for SOA<uint8_t, uint16_t, uint32_t, uint64_t>\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    auto tup = SOA<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+    for (uint64_t i = 0; i < number_of_elements; i++) {
+      tup.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+    }
+    uint64_t start = 0;
+    uint64_t end = 0;
+
+    {
+      start = get_time();
+      auto bigger =
+          SOA<uint8_t, uint16_t, uint32_t, uint64_t>(2 * number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        bigger.get(i) = tup.get(i);
+      }
+      for (uint64_t i = number_of_elements; i < 2 * number_of_elements; i++) {
+        bigger.get(i) = std::tuple<uint8_t, uint16_t, uint32_t, uint64_t>();
+      }
+      end = get_time();
+      std::cout << "element wise grow time was " << end - start << "\n";
+    }
+    {
+      start = get_time();
+      auto bigger = tup.resize(2 * number_of_elements);
+      end = get_time();
+      std::cout << "grow with zeroed tail time was " << end - start
+                << "  last was "
+                << std::get<0>(bigger.get<3>(2 * number_of_elements - 1))
+                << "\n";
+    }
+    {
+      start = get_time();
+      auto smaller = tup.resize(number_of_elements / 2);
+      end = get_time();
+      std::cout << "shrink time was " << end - start << "\n";
+    }
+    {
+      auto sized_tup = SOA<sized_uint<3>, sized_uint<5>>(number_of_elements);
+      sized_tup.zero();
+      start = get_time();
+      auto bigger = sized_tup.resize(2 * number_of_elements);
+      end = get_time();
+      std::cout << "sized_uint grow with zeroed tail time was " << end - start
+                << "\n";
+    }
+    {
+      auto copy = tup.resize(number_of_elements);
+      start = get_time();
+      copy.reserve(2 * number_of_elements);
+      end = get_time();
+      std::cout << "reserve time was " << end - start << "\n";
+      start = get_time();
+      copy.shrink_to_fit();
+      end = get_time();
+      std::cout << "shrink_to_fit time was " << end - start << "  last was "
+                << std::get<0>(copy.get<3>(number_of_elements - 1)) << "\n";
+    }
+    {
+      // the tail a resize clears shares a byte with the last row kept when
+      // the rows are not a whole number of bytes wide
+      bool kept = true;
+      for (size_t n : {1, 7, 10, 65}) {
+        auto packed = SOA<packed_uint<11>, packed_uint<5>>(n + 3);
+        for (size_t i = 0; i < n + 3; i++) {
+          packed.get(i) = std::make_tuple(2047, 31);
+        }
+        auto smaller = packed.resize(n);
+        smaller.reserve(2 * n);
+        smaller.shrink_to_fit();
+        kept &= uint64_t(smaller.sum<0>()) == 2047 * n &&
+                uint64_t(smaller.sum<1>()) == 31 * n;
+      }
+      std::cout << "packed_uint rows kept by resize "
+                << (kept ? "match" : "DO NOT match") << "\n";
+    }
+  }
+
+  if (argc > 1 && (flag & 64)) {
+    std::cout << "\nlayouts for SOA<uint8_t, uint16_t, uint32_t, uint64_t>\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    std::cout << "natural alignment\n";
+    time_layout_scans<SOALayout<1>>(number_of_elements);
+    std::cout << "64 byte alignment\n";
+    time_layout_scans<SOALayout<64>>(number_of_elements);
+    std::cout << "64 byte alignment with 64 bytes of tail padding\n";
+    time_layout_scans<SOALayout<64, 64>>(number_of_elements);
+    std::cout << "4096 byte alignment\n";
+    time_layout_scans<SOALayout<4096>>(number_of_elements);
+  }
+
+  if (argc > 1 && (flag & 128)) {
+    std::cout << "\nallocators for SOA<uint8_t, uint16_t, uint32_t, "
+                 "uint64_t>\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    std::cout << "malloc\n";
+    time_allocator<MallocAllocator>(number_of_elements);
+    std::cout << "pmr monotonic buffer\n";
+    {
+      std::pmr::monotonic_buffer_resource arena;
+      time_allocator<PmrAllocator>(number_of_elements, PmrAllocator(&arena));
+    }
+    std::cout << "transparent huge pages\n";
+    time_allocator<HugePageAllocator>(number_of_elements);
+    std::cout << "explicit huge pages\n";
+    time_allocator<HugePageAllocator>(number_of_elements,
+                                      HugePageAllocator(true));
+  }
+
+  if (argc > 1 && (flag & 256)) {
+    std::cout << "\nrow and column access for <uint8_t, uint16_t, uint32_t, "
+                 "uint64_t>\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    std::cout << "SOA\n";
+    time_row_matrix<SOA<uint8_t, uint16_t, uint32_t, uint64_t>>(
+        number_of_elements);
+    std::cout << "AOS\n";
+    time_row_matrix<AOS<uint8_t, uint16_t, uint32_t, uint64_t>>(
+        number_of_elements);
+    std::cout << "AOSOA<16>\n";
+    time_row_matrix<AOSOA<16, uint8_t, uint16_t, uint32_t, uint64_t>>(
+        number_of_elements);
+    std::cout << "AOSOA<64>\n";
+    time_row_matrix<AOSOA<64, uint8_t, uint16_t, uint32_t, uint64_t>>(
+        number_of_elements);
+    std::cout << "AOSOA<256>\n";
+    time_row_matrix<AOSOA<256, uint8_t, uint16_t, uint32_t, uint64_t>>(
+        number_of_elements);
+  }
+
+  if (argc > 1 && (flag & 512)) {
+    std::cout << "\nparallel scans for <uint8_t, uint16_t, uint32_t, "
+                 "uint64_t>\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    auto tup = SOA<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+    auto tup_aos =
+        AOS<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+    tup.parallel_map_range_with_index([](size_t i, auto &...args) {
+      std::forward_as_tuple(args...) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+    });
+    tup_aos.parallel_map_range_with_index([](size_t i, auto &...args) {
+      std::forward_as_tuple(args...) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+    });
+#if CILK == 1
+    // the number of workers is fixed by CILK_NWORKERS
+    std::cout << "SOA with " << get_num_workers() << " workers\n";
+    time_parallel_scans(tup);
+    std::cout << "AOS with " << get_num_workers() << " workers\n";
+    time_parallel_scans(tup_aos);
+#else
+    size_t max_workers = std::max(1U, std::thread::hardware_concurrency());
+    for (size_t workers = 1;; workers = std::min(2 * workers, max_workers)) {
+      ThreadPool::get().set_num_workers(workers);
+      std::cout << "SOA with " << get_num_workers() << " workers\n";
+      time_parallel_scans(tup);
+      std::cout << "AOS with " << get_num_workers() << " workers\n";
+      time_parallel_scans(tup_aos);
+      if (workers == max_workers) {
+        break;
+      }
+    }
+#endif
+  }
+
+  if (argc > 1 && (flag & 1024)) {
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    {
+      std::cout << "\nreductions for SOA<uint8_t, uint16_t, uint32_t, "
+                   "uint64_t>\n";
+      auto tup = SOA<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        tup.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+      }
+      time_reductions(tup);
+    }
+    {
+      std::cout << "\nreductions for SOA<sized_uint<3>, sized_uint<5>, "
+                   "sized_uint<6>, sized_uint<7>>\n";
+      auto tup =
+          SOA<sized_uint<3>, sized_uint<5>, sized_uint<6>, sized_uint<7>>(
+              number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        tup.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+      }
+      time_reductions(tup);
+    }
+    {
+      std::cout << "\nreductions for AOS<uint8_t, uint16_t, uint32_t, "
+                   "uint64_t>\n";
+      auto tup = AOS<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        tup.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+      }
+      time_reductions(tup);
+    }
+  }
+
+  if (argc > 1 && (flag & 2048)) {
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    {
+      std::cout << "\nsimd scans for SOA<uint8_t, uint16_t, uint32_t, "
+                   "uint64_t>\n";
+      auto tup = SOA<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        tup.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+      }
+      time_simd_scans(tup);
+    }
+    {
+      std::cout << "\nsimd scans for SOA<sized_uint<3>, sized_uint<5>, "
+                   "sized_uint<6>, sized_uint<7>>\n";
+      auto tup =
+          SOA<sized_uint<3>, sized_uint<5>, sized_uint<6>, sized_uint<7>>(
+              number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        tup.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+      }
+      time_simd_scans(tup);
+    }
+  }
+
+  if (argc > 1 && (flag & 4096)) {
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    std::cout << "\ncolumn spans for SOA<uint8_t, uint16_t, uint32_t, "
+                 "uint64_t>\n";
+    auto tup = SOA<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+    for (uint64_t i = 0; i < number_of_elements; i++) {
+      tup.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+    }
+    time_column_spans(tup);
+  }
+
+  if (argc > 1 && (flag & 8192)) {
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    std::cout << "\nrandom access for SOA<uint8_t, uint16_t, uint32_t, "
+                 "uint64_t>\n";
+    auto tup = SOA<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+    std::mt19937_64 gen(0);
+    for (uint64_t i = 0; i < number_of_elements; i++) {
+      uint64_t r = gen();
+      tup.get(i) = std::make_tuple(r, r >> 8U, r >> 16U, r >> 32U);
+    }
+    std::vector<uint64_t> indices(number_of_elements);
+    std::uniform_int_distribution<uint64_t> dist(0, number_of_elements - 1);
+    for (auto &i : indices) {
+      i = dist(gen);
+    }
+    time_random_access(tup, indices);
+  }
+
+  if (argc > 1 && (flag & 16384)) {
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    std::mt19937_64 gen(0);
+    {
+      std::cout << "\nsort by key for SOA<uint8_t, uint16_t, uint32_t, "
+                   "uint64_t>\n";
+      using Container = SOA<uint8_t, uint16_t, uint32_t, uint64_t>;
+      auto original = Container(number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        uint64_t r = gen();
+        original.get(i) = std::make_tuple(r, r >> 8U, r >> 16U, r >> 32U);
+      }
+      auto tup = Container(number_of_elements);
+      time_sort_by<3>(tup, original);
+    }
+    {
+      std::cout << "\nsort by key for SOA<sized_uint<3>, sized_uint<5>, "
+                   "sized_uint<6>, sized_uint<7>>\n";
+      using Container =
+          SOA<sized_uint<3>, sized_uint<5>, sized_uint<6>, sized_uint<7>>;
+      auto original = Container(number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        uint64_t r = gen();
+        original.get(i) = std::make_tuple(r, r >> 8U, r >> 16U, r >> 24U);
+      }
+      auto tup = Container(number_of_elements);
+      time_sort_by<0>(tup, original);
+    }
+  }
+
+  if (argc > 1 && (flag & 32768)) {
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    std::mt19937_64 gen(0);
+    {
+      std::cout << "\nradix sort for SOA<uint8_t, uint16_t, uint32_t, "
+                   "uint64_t>\n";
+      using Container = SOA<uint8_t, uint16_t, uint32_t, uint64_t>;
+      auto original = Container(number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        uint64_t r = gen();
+        original.get(i) = std::make_tuple(r, r >> 8U, r >> 16U, r);
+      }
+      auto tup = Container(number_of_elements);
+      time_radix_sort_by<2>(tup, original);
+      time_radix_sort_by<3>(tup, original);
+    }
+    {
+      std::cout << "\nradix sort for SOA<sized_uint<3>, sized_uint<5>, "
+                   "sized_uint<6>, sized_uint<7>>\n";
+      using Container =
+          SOA<sized_uint<3>, sized_uint<5>, sized_uint<6>, sized_uint<7>>;
+      auto original = Container(number_of_elements);
+      for (uint64_t i = 0; i < number_of_elements; i++) {
+        uint64_t r = gen();
+        original.get(i) = std::make_tuple(r, r >> 8U, r >> 16U, r >> 24U);
+      }
+      auto tup = Container(number_of_elements);
+      time_radix_sort_by<0>(tup, original);
+      time_radix_sort_by<1>(tup, original);
+    }
+  }
+
+  if (argc > 1 && (flag & 65536)) {
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    std::mt19937_64 gen(0);
+    using Container = SOA<uint8_t, uint16_t, uint32_t, uint64_t>;
+    auto original = Container(number_of_elements);
+    for (uint64_t i = 0; i < number_of_elements; i++) {
+      uint64_t r = gen();
+      original.get(i) = std::make_tuple(r % 100, r >> 8U, r >> 16U, r);
+    }
+    for (uint64_t dropped : {10, 30, 50, 70, 90}) {
+      std::cout << "\nerase_if dropping " << dropped
+                << "% of SOA<uint8_t, uint16_t, uint32_t, uint64_t>\n";
+      time_erase_if(original, dropped);
+    }
+  }
+
+  if (argc > 1 && (flag & 131072)) {
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    auto soa = SOA<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+    auto aos = AOS<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+    for (uint64_t i = 0; i < number_of_elements; i++) {
+      soa.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+      aos.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+    }
+    std::mt19937_64 gen(0);
+    std::vector<uint64_t> indices(number_of_elements);
+
+    std::cout << "\nuniform random lookups\n";
+    std::uniform_int_distribution<uint64_t> dist(0, number_of_elements - 1);
+    for (auto &i : indices) {
+      i = dist(gen);
+    }
+    time_gathers(soa, aos, indices);
+
+    // the density of x^u for uniform u falls off as 1/x, like a Zipfian
+    // distribution with exponent 1
+    std::cout << "\nzipfian random lookups\n";
+    std::uniform_real_distribution<double> unit(0, 1);
+    for (auto &i : indices) {
+      i = static_cast<uint64_t>(
+              std::pow(static_cast<double>(number_of_elements), unit(gen))) -
+          1;
+    }
+    time_gathers(soa, aos, indices);
+  }
+
+  if (argc > 1 && (flag & 262144)) {
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    const char *path = "/tmp/soa_mapped_benchmark";
+    uint64_t start = 0;
+    uint64_t end = 0;
+    auto fill = [](auto &soa) {
+      for (uint64_t i = 0; i < soa.size(); i++) {
+        soa.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+      }
+    };
+
+    start = get_time();
+    {
+      auto soa = SOA<uint8_t, uint16_t, uint32_t, uint64_t>(number_of_elements);
+      fill(soa);
+      std::cout << "building in memory, sum was " << soa.sum() << "\n";
+    }
+    end = get_time();
+    std::cout << "building in memory time was " << end - start << "\n";
+
+    start = get_time();
+    {
+      MappedSOA<uint8_t, uint16_t, uint32_t, uint64_t> mapped;
+      if (!mapped.create(path, number_of_elements)) {
+        std::cout << "create failed: " << mapped.error() << "\n";
+        return 1;
+      }
+      mapped.map_range_with_index([](uint64_t i, uint8_t &a, uint16_t &b,
+                                     uint32_t &c, uint64_t &d) {
+        a = i;
+        b = 2 * i;
+        c = 3 * i;
+        d = 4 * i;
+      });
+      if (mapped.push_back(std::make_tuple(0, 0, 0, 0))) {
+        std::cout << "push_back past the capacity of the file succeeded\n";
+      }
+      mapped.sync();
+    }
+    end = get_time();
+    std::cout << "building the file time was " << end - start << "\n";
+
+    for (MapMode mode :
+         {MapMode::read_only, MapMode::read_write, MapMode::copy_on_write}) {
+      MappedSOA<uint8_t, uint16_t, uint32_t, uint64_t> mapped;
+      start = get_time();
+      if (!mapped.open(path, mode)) {
+        std::cout << "open failed: " << mapped.error() << "\n";
+        return 1;
+      }
+      end = get_time();
+      std::cout << "open time was " << end - start << "\n";
+      mapped.advise(MADV_SEQUENTIAL);
+      start = get_time();
+      auto sum = mapped.soa().sum();
+      end = get_time();
+      std::cout << "first sum after open time was " << end - start
+                << "  sum was " << sum << "\n";
+      if (mode == MapMode::read_only && mapped.set<0>(0, std::make_tuple(1))) {
+        std::cout << "writing to a read only mapping succeeded\n";
+      }
+    }
+
+    MappedSOA<uint8_t, uint32_t, uint16_t, uint64_t> wrong_types;
+    if (!wrong_types.open(path)) {
+      std::cout << "opening with the wrong types failed with: "
+                << wrong_types.error() << "\n";
+    }
+    unlink(path);
+  }
+
+  if (argc > 1 && (flag & 524288)) {
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    using SOAContainer = SOA<uint8_t, uint16_t, uint32_t, uint64_t>;
+    const char *path = "/tmp/soa_save_benchmark";
+    auto soa = SOAContainer(number_of_elements);
+    for (uint64_t i = 0; i < number_of_elements; i++) {
+      soa.get(i) = std::make_tuple(i, 2 * i, 3 * i, 4 * i);
+    }
+    uint64_t start = get_time();
+    if (!soa.save(path)) {
+      std::cout << "save failed\n";
+      return 1;
+    }
+    uint64_t end = get_time();
+    size_t bytes = number_of_elements * sizeof(SOAContainer::T);
+    std::cout << "save time was " << end - start << "  bandwidth was "
+              << bytes / std::max(end - start, uint64_t(1)) << " MB/s\n";
+
+    for (bool cold : {false, true}) {
+      time_load<SOAContainer>(path, cold);
+      time_load<SOAContainer, 3>(path, cold);
+      time_load<SOAContainer, 0, 2>(path, cold);
+    }
+    unlink(path);
+  }
+
+  if (argc > 1 && (flag & 1048576)) {
+    std::cout << "\nframe of reference encoded timestamps\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    std::mt19937 g(0);
+    std::uniform_int_distribution<uint64_t> step(0, 100);
+    std::vector<uint64_t> timestamps(number_of_elements);
+    uint64_t t = 1700000000000000;
+    for (uint64_t &x : timestamps) {
+      t += step(g);
+      x = t;
+    }
+    std::uniform_int_distribution<uint64_t> index(0, number_of_elements - 1);
+    std::vector<uint64_t> indices(std::min<uint64_t>(number_of_elements,
+                                                     1000000));
+    for (uint64_t &i : indices) {
+      i = index(g);
+    }
+    time_timestamp_column<SOA<uint64_t>>("uint64_t", timestamps, indices);
+    time_timestamp_column<SOA<sized_uint<7>>>("sized_uint<7>", timestamps,
+                                              indices);
+    time_timestamp_column<SOA<frame_uint<16>>>("frame_uint<16>", timestamps,
+                                               indices);
+    time_timestamp_column<SOA<frame_uint<13>>>("frame_uint<13>", timestamps,
+                                               indices);
+  }
+
+  if (argc > 1 && (flag & 2097152)) {
+    std::cout << "\ndictionary encoded low cardinality columns\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    time_low_cardinality<SOA<uint32_t, uint16_t>, false>(
+        "SOA<uint32_t, uint16_t>", number_of_elements);
+    time_low_cardinality<SOA<dict<uint32_t, 8>, dict<uint16_t, 64>>, true>(
+        "SOA<dict<uint32_t, 8>, dict<uint16_t, 64>>", number_of_elements);
+    time_low_cardinality<SOA<dict<uint32_t>, dict<uint16_t>>, true>(
+        "SOA<dict<uint32_t>, dict<uint16_t>>", number_of_elements);
+  }
+
+  if (argc > 1 && (flag & 4194304)) {
+    std::cout << "\nbit packed flag columns\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    for (uint64_t one_in : {2, 100, 10000}) {
+      time_flag_column<SOA<uint64_t, bool>, false>(
+          "SOA<uint64_t, bool>", number_of_elements, one_in);
+      time_flag_column<SOA<uint64_t, bit>, true>("SOA<uint64_t, bit>",
+                                                 number_of_elements, one_in);
+    }
+  }
+
+  if (argc > 1 && (flag & 8388608)) {
+    std::cout << "\nprojecting 2 of 8 columns\n";
+    time_projection(std::strtol(argv[1], nullptr, 10));
+  }
+
+  if (argc > 1 && (flag & 16777216)) {
+    std::cout << "\nownership of the block\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    check_ownership<SOA<uint64_t, uint32_t, uint16_t>>(number_of_elements);
+    check_ownership<SOA<uint32_t, packed_uint<11>, bit>>(number_of_elements);
+  }
+
+  if (argc > 1 && (flag & 33554432)) {
+    std::cout << "\nbatches of 64 rows inserted into and erased from the "
+                 "middle of a table\n";
+    uint64_t number_of_elements = std::strtol(argv[1], nullptr, 10);
+    time_mid_table_updates<false>(number_of_elements, 1000, 64);
+    time_mid_table_updates<true>(number_of_elements, 1000, 64);
+  }
+
+  if (argc > 1 && (flag & 67108864)) {
+    std::cout << "\nrandom inserts into a table sorted by key\n";
+    time_ordered_inserts(std::strtol(argv[1], nullptr, 10));
+  }
+
   return 0;
 }